@@ -0,0 +1,345 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file analyzer.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ht_analyze.h"
+
+/**
+ * @brief Named hash function
+ *
+ */
+typedef struct {
+  /**
+   * @brief Name given to -f
+   *
+   */
+  const char *      name;
+
+  /**
+   * @brief Function to get hash from key
+   *
+   */
+  hash_function_t   hash_function;
+} analyze_hash_t;
+
+static uint32_t analyze_key_size;
+
+
+/**
+ * @brief Function to load the first 4 bytes of a key, zero padded
+ *
+ * @param key Key
+ * @return uint32_t Value
+ */
+static inline uint32_t analyze_load(uint8_t *key)
+{
+  uint32_t value;
+
+  value = 0;
+  memcpy(&value, key, analyze_key_size < sizeof(value) ? analyze_key_size :
+      sizeof(value));
+
+  return (value);
+}
+
+
+/**
+ * @brief The hash of the basic test, groups of 8 keys share a hash
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t analyze_hash_basic(uint8_t *key)
+{
+  return ((analyze_load(key) * 32) >> 8);
+}
+
+
+/**
+ * @brief The first 4 bytes of the key
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t analyze_hash_identity(uint8_t *key)
+{
+  return (analyze_load(key));
+}
+
+
+/**
+ * @brief FNV-1a over every byte of the key
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t analyze_hash_fnv1a(uint8_t *key)
+{
+  uint32_t i;
+  uint32_t hash;
+
+  hash = 2166136261u;
+  for (i = 0; i < analyze_key_size; i++)
+  {
+    hash ^= key[i];
+    hash *= 16777619u;
+  }
+
+  return (hash);
+}
+
+
+/**
+ * @brief Murmur3 finalizer over every 4 bytes of the key
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t analyze_hash_murmur3(uint8_t *key)
+{
+  uint32_t i;
+  uint32_t word;
+  uint32_t hash;
+
+  hash = analyze_key_size;
+  for (i = 0; i < analyze_key_size; i += sizeof(word))
+  {
+    word = 0;
+    memcpy(&word, key + i, analyze_key_size - i < sizeof(word) ?
+        analyze_key_size - i : sizeof(word));
+    hash ^= word;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+  }
+
+  return (hash);
+}
+
+
+static const analyze_hash_t analyze_hashes[] =
+{
+  { "basic",    analyze_hash_basic    },
+  { "identity", analyze_hash_identity },
+  { "fnv1a",    analyze_hash_fnv1a    },
+  { "murmur3",  analyze_hash_murmur3  },
+};
+
+
+/**
+ * @brief Function to print the usage
+ *
+ * @param name Program name
+ */
+static void analyze_usage(const char *name)
+{
+  uint32_t i;
+
+  fprintf(stderr, "usage: %s [-f hash] [-k key_size] [-l load | -s size] "
+      "(-g count | keys)\n", name);
+  fprintf(stderr, "Analyzes a hash over a file of fixed size keys, or "
+      "count generated integers, and prints the result as JSON\n");
+  fprintf(stderr, "hashes:");
+  for (i = 0; i < sizeof(analyze_hashes) / sizeof(analyze_hashes[0]); i++)
+  {
+    fprintf(stderr, " %s", analyze_hashes[i].name);
+  }
+  fprintf(stderr, "\n");
+}
+
+
+/**
+ * @brief Function to print a value in thousandths
+ *
+ * @param name JSON name
+ * @param value Value in thousandths, UINT32_MAX for infinity
+ */
+static void analyze_print(const char *name, uint32_t value)
+{
+  if (value == UINT32_MAX) {
+    printf("\"%s\": null, ", name);
+  } else {
+    printf("\"%s\": %.3f, ", name, value / 1000.0);
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  int option;
+  long file_size;
+  FILE *file;
+  uint8_t *keys;
+  uint32_t i;
+  uint32_t load;
+  uint32_t size;
+  uint32_t count;
+  uint32_t *work;
+  uint64_t value;
+  const analyze_hash_t *hash;
+  ht_analyze_t analyze;
+
+  hash = &analyze_hashes[0];
+  analyze_key_size = sizeof(uint32_t);
+  load = 50;
+  size = 0;
+  count = 0;
+
+  while ((option = getopt(argc, argv, "f:k:l:s:g:h")) != -1)
+  {
+    switch (option) {
+    case 'f':
+      for (i = 0; i < sizeof(analyze_hashes) / sizeof(analyze_hashes[0]);
+           i++)
+      {
+        if (!strcmp(optarg, analyze_hashes[i].name)) {
+          break;
+        }
+      }
+      if (i == sizeof(analyze_hashes) / sizeof(analyze_hashes[0])) {
+        analyze_usage(argv[0]);
+        return (1);
+      }
+      hash = &analyze_hashes[i];
+      break;
+    case 'k':
+      analyze_key_size = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      load = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 's':
+      size = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'g':
+      count = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    default:
+      analyze_usage(argv[0]);
+      return (option == 'h' ? 0 : 1);
+    }
+  }
+
+  if (!analyze_key_size || !load || load > 100 ||
+      (count ? optind != argc : optind + 1 != argc)) {
+    analyze_usage(argv[0]);
+    return (1);
+  }
+
+  if (count) {
+    /* Little endian integers 0 to count - 1 */
+    keys = calloc(count, analyze_key_size);
+    if (!keys) {
+      fprintf(stderr, "out of memory\n");
+      return (1);
+    }
+    for (i = 0; i < count; i++)
+    {
+      value = i;
+      memcpy(keys + (size_t)i * analyze_key_size, &value,
+          analyze_key_size < sizeof(value) ? analyze_key_size :
+          sizeof(value));
+    }
+  } else {
+    file = fopen(argv[optind], "rb");
+    if (!file || fseek(file, 0, SEEK_END) ||
+        (file_size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) ||
+        (uint64_t)file_size / analyze_key_size > UINT32_MAX) {
+      fprintf(stderr, "cannot read %s\n", argv[optind]);
+      return (1);
+    }
+    count = (uint32_t)((uint64_t)file_size / analyze_key_size);
+    keys = malloc(count ? (size_t)count * analyze_key_size : 1);
+    if (!keys || fread(keys, analyze_key_size, count, file) != count) {
+      fprintf(stderr, "cannot read %s\n", argv[optind]);
+      return (1);
+    }
+    fclose(file);
+  }
+
+  if (!size) {
+    size = (uint32_t)(((uint64_t)count * 100 + load - 1) / load);
+  }
+
+  work = malloc((size_t)size * sizeof(uint32_t));
+  if (!work || !ht_analyze(hash->hash_function, keys, count,
+      analyze_key_size, size, work, &analyze)) {
+    fprintf(stderr, "cannot analyze %u keys in %u entries\n", count, size);
+    return (1);
+  }
+
+  printf("{\"hash\": \"%s\", \"size\": %u, \"count\": %u, \"key_size\": %u, ",
+      hash->name, analyze.size, analyze.count, analyze_key_size);
+  printf("\"chi_square\": %.3f, \"chi_square_ratio\": %.3f, ",
+      analyze.chi_square / 1000.0,
+      size > 1 ? analyze.chi_square / 1000.0 / (size - 1) : 0.0);
+  analyze_print("avalanche_mean", analyze.avalanche_mean);
+  analyze_print("avalanche_bias", analyze.avalanche_bias);
+  analyze_print("probe_hit_expected", analyze.probe_hit_expected);
+  analyze_print("probe_hit", analyze.probe_hit);
+  analyze_print("probe_miss_expected", analyze.probe_miss_expected);
+  analyze_print("probe_miss", analyze.probe_miss);
+  printf("\"max_probe\": %u, \"clusters\": %u, \"largest_cluster\": %u, ",
+      analyze.max_probe, analyze.clusters, analyze.largest_cluster);
+  printf("\"cluster_histogram\": [");
+  for (i = 0; i < HT_ANALYZE_CLUSTER_BUCKETS; i++)
+  {
+    printf("%s%u", i ? ", " : "", analyze.cluster_histogram[i]);
+  }
+  printf("], \"warnings\": [");
+
+  /* Explain what makes the table slow */
+  i = 0;
+  if (size > 1 && analyze.chi_square > (uint64_t)(size - 1) * 1500) {
+    printf("%s\"keys are not spread evenly over the entries\"",
+        i++ ? ", " : "");
+  }
+  if (analyze.avalanche_bias > 100) {
+    printf("%s\"some key bits barely change some hash bits\"",
+        i++ ? ", " : "");
+  }
+  if (analyze.probe_miss_expected != UINT32_MAX &&
+      analyze.probe_miss / 2 > analyze.probe_miss_expected) {
+    printf("%s\"clusters are longer than with a uniform hash\"",
+        i++ ? ", " : "");
+  }
+  printf("]}\n");
+
+  return (0);
+}
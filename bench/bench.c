@@ -0,0 +1,489 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file bench.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ht.h"
+#include "bench_chain.h"
+
+/**
+ * @brief Smallest table, about the size of a L1 data cache
+ *
+ */
+#define BENCH_MIN_BYTES        (16 * 1024)
+
+/**
+ * @brief Default largest table
+ *
+ */
+#define BENCH_MAX_BYTES        (64 * 1024 * 1024)
+
+/**
+ * @brief Growth factor between table sizes
+ *
+ */
+#define BENCH_BYTES_STEP       8
+
+/**
+ * @brief Largest key and data sizes
+ *
+ */
+#define BENCH_KEY_MAX          64
+#define BENCH_DATA_MAX         64
+
+/**
+ * @brief Benchmark result, nanoseconds per operation
+ *
+ */
+typedef struct {
+  /**
+   * @brief Insert of a new key
+   *
+   */
+  double        insert;
+
+  /**
+   * @brief Lookup of a stored key
+   *
+   */
+  double        hit;
+
+  /**
+   * @brief Lookup of a missing key
+   *
+   */
+  double        miss;
+
+  /**
+   * @brief Remove of a stored key
+   *
+   */
+  double        remove;
+} bench_result_t;
+
+static const uint32_t bench_key_sizes[] = { 4, 8, 16, 64 };
+static const uint32_t bench_data_sizes[] = { 8, 64 };
+static const uint32_t bench_loads[] = { 50, 75, 90, 95 };
+
+static const char *bench_probe_names[] = { "linear", "triangular", "double" };
+
+static uint32_t bench_key_size;
+static uint32_t bench_probe;
+static uint32_t bench_power;
+static uint32_t bench_weak;
+
+/**
+ * @brief Function to get the monotonic time
+ *
+ * @return uint64_t Time in nanoseconds
+ */
+static uint64_t bench_now(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec);
+}
+
+
+/**
+ * @brief Function to build the key number i, different numbers give
+ * different keys
+ *
+ * @param i Key number
+ * @param[out] key Key of bench_key_size bytes
+ */
+static inline void bench_key(uint64_t i, uint8_t *key)
+{
+  uint32_t j;
+  uint64_t value;
+
+  value = i * 0x9e3779b97f4a7c15ull;
+
+  for (j = 0; j < bench_key_size; j += sizeof(value))
+  {
+    memcpy(key + j, &value, bench_key_size - j < sizeof(value) ?
+        bench_key_size - j : sizeof(value));
+  }
+}
+
+
+/**
+ * @brief Function to get hash from a key of bench_key_size bytes
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t bench_hash_function(uint8_t *key)
+{
+  uint32_t j;
+  uint64_t hash;
+  uint64_t word;
+
+  hash = 0;
+  for (j = 0; j < bench_key_size; j += sizeof(word))
+  {
+    word = 0;
+    memcpy(&word, key + j, bench_key_size - j < sizeof(word) ?
+        bench_key_size - j : sizeof(word));
+    hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+    hash ^= hash >> 32;
+  }
+
+  /* A weak hash only uses one first entry in 16, like aligned addresses */
+  if (bench_weak) {
+    hash &= ~(uint64_t)15;
+  }
+
+  return ((uint32_t)hash);
+}
+
+
+/**
+ * @brief Function to benchmark the hash table
+ *
+ * @param entries Number of entries
+ * @param count Number of items
+ * @param data_size Size of the data in bytes
+ * @param data Entries buffer
+ * @param[out] result Result
+ * @return uint8_t 1 if every operation gave the expected answer else 0
+ */
+static uint8_t bench_ht(uint32_t entries, uint32_t count, uint32_t data_size,
+    uint8_t *data, bench_result_t *result)
+{
+  ht_t hash_table;
+  uint64_t i;
+  uint64_t start;
+  uint64_t found;
+  uint8_t key[BENCH_KEY_MAX];
+  uint8_t value[BENCH_DATA_MAX];
+
+  memset(data, 0, (size_t)entries *
+      (sizeof(ht_entry_t) + bench_key_size + data_size));
+  memset(value, 0, sizeof(value));
+  if (!ht_init_probe(&hash_table, bench_hash_function, entries, data_size,
+      bench_key_size, data, bench_probe)) {
+    return (0);
+  }
+
+  found = 0;
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    memcpy(value, &i, sizeof(i));
+    found += ht_insert(&hash_table, key, value);
+  }
+  result->insert = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    found += ht_get(&hash_table, key, value);
+  }
+  result->hit = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = count; i < 2 * (uint64_t)count; i++)
+  {
+    bench_key(i, key);
+    found += ht_get(&hash_table, key, value);
+  }
+  result->miss = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    found += ht_remove(&hash_table, key, NULL);
+  }
+  result->remove = (double)(bench_now() - start) / count;
+
+  return (found == 3 * (uint64_t)count);
+}
+
+
+/**
+ * @brief Function to benchmark the chained hash table
+ *
+ * @param entries Number of buckets
+ * @param count Number of items
+ * @param data_size Size of the data in bytes
+ * @param buckets Buckets buffer
+ * @param nodes Nodes buffer
+ * @param[out] result Result
+ * @return uint8_t 1 if every operation gave the expected answer else 0
+ */
+static uint8_t bench_chain(uint32_t entries, uint32_t count,
+    uint32_t data_size, bench_chain_node_t **buckets, uint8_t *nodes,
+    bench_result_t *result)
+{
+  bench_chain_t chain;
+  uint64_t i;
+  uint64_t start;
+  uint64_t found;
+  uint8_t key[BENCH_KEY_MAX];
+  uint8_t value[BENCH_DATA_MAX];
+
+  memset(value, 0, sizeof(value));
+  bench_chain_init(&chain, bench_hash_function, entries, buckets, nodes,
+      count, bench_key_size, data_size);
+
+  found = 0;
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    memcpy(value, &i, sizeof(i));
+    found += bench_chain_insert(&chain, key, value);
+  }
+  result->insert = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    found += bench_chain_get(&chain, key, value);
+  }
+  result->hit = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = count; i < 2 * (uint64_t)count; i++)
+  {
+    bench_key(i, key);
+    found += bench_chain_get(&chain, key, value);
+  }
+  result->miss = (double)(bench_now() - start) / count;
+
+  start = bench_now();
+  for (i = 0; i < count; i++)
+  {
+    bench_key(i, key);
+    found += bench_chain_remove(&chain, key);
+  }
+  result->remove = (double)(bench_now() - start) / count;
+
+  return (found == 3 * (uint64_t)count);
+}
+
+
+/**
+ * @brief Function to print a result as a JSON object
+ *
+ * @param name Name of the table
+ * @param result Result
+ */
+static void bench_print(const char *name, bench_result_t *result)
+{
+  printf("\"%s\": {\"insert\": %.2f, \"hit\": %.2f, \"miss\": %.2f, "
+      "\"remove\": %.2f}", name, result->insert, result->hit,
+      result->miss, result->remove);
+}
+
+
+/**
+ * @brief Function to print the usage
+ *
+ * @param name Program name
+ */
+static void bench_usage(const char *name)
+{
+  fprintf(stderr, "usage: %s [-n min_bytes] [-m max_bytes] "
+      "[-p linear|triangular|double] [-w]\n", name);
+  fprintf(stderr, "Prints the nanoseconds per operation as JSON, tables "
+      "grow %dx from min_bytes (%d) to max_bytes (%d)\n", BENCH_BYTES_STEP,
+      BENCH_MIN_BYTES, BENCH_MAX_BYTES);
+  fprintf(stderr, "  -p  probe sequence of ht, entries are rounded down to "
+      "a power of two so every sequence runs on the same sizes\n");
+  fprintf(stderr, "  -w  weak hash, the low 4 bits of every hash are clear\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  int option;
+  uint8_t first;
+  uint8_t failed;
+  uint8_t *data;
+  uint8_t *nodes;
+  uint32_t k;
+  uint32_t d;
+  uint32_t l;
+  uint32_t p;
+  uint32_t count;
+  uint32_t entries;
+  uint32_t data_size;
+  uint64_t bytes;
+  uint64_t min_bytes;
+  uint64_t max_bytes;
+  uint64_t entry_size;
+  bench_chain_node_t **buckets;
+  bench_result_t ht_result;
+  bench_result_t chain_result;
+
+  min_bytes = BENCH_MIN_BYTES;
+  max_bytes = BENCH_MAX_BYTES;
+
+  while ((option = getopt(argc, argv, "n:m:p:wh")) != -1)
+  {
+    switch (option) {
+    case 'n':
+      min_bytes = strtoull(optarg, NULL, 0);
+      break;
+    case 'm':
+      max_bytes = strtoull(optarg, NULL, 0);
+      break;
+    case 'p':
+      for (p = 0; p < sizeof(bench_probe_names) / sizeof(bench_probe_names[0]);
+           p++)
+      {
+        if (!strcmp(optarg, bench_probe_names[p])) {
+          break;
+        }
+      }
+      if (p == sizeof(bench_probe_names) / sizeof(bench_probe_names[0])) {
+        bench_usage(argv[0]);
+        return (1);
+      }
+      bench_probe = p;
+      bench_power = 1;
+      break;
+    case 'w':
+      bench_weak = 1;
+      break;
+    default:
+      bench_usage(argv[0]);
+      return (option == 'h' ? 0 : 1);
+    }
+  }
+
+  if (!min_bytes || min_bytes > max_bytes) {
+    bench_usage(argv[0]);
+    return (1);
+  }
+
+  first = 1;
+  failed = 0;
+  entries = 0;
+  printf("{\"results\": [\n");
+
+  /* A failure stops every loop, the JSON is still closed below */
+  for (bytes = min_bytes; !failed && bytes <= max_bytes;
+       bytes *= BENCH_BYTES_STEP)
+  {
+    for (k = 0; !failed &&
+         k < sizeof(bench_key_sizes) / sizeof(bench_key_sizes[0]); k++)
+    {
+      bench_key_size = bench_key_sizes[k];
+
+      for (d = 0; !failed &&
+           d < sizeof(bench_data_sizes) / sizeof(bench_data_sizes[0]); d++)
+      {
+        data_size = bench_data_sizes[d];
+        entry_size = sizeof(ht_entry_t) + bench_key_size + data_size;
+        if (bytes / entry_size < 2 || bytes / entry_size > UINT32_MAX) {
+          continue;
+        }
+        entries = (uint32_t)(bytes / entry_size);
+        if (bench_power) {
+          while (entries & (entries - 1))
+          {
+            entries &= entries - 1;
+          }
+        }
+
+        data = malloc(bytes);
+        buckets = malloc((size_t)entries * sizeof(bench_chain_node_t *));
+        nodes = malloc((size_t)entries *
+            BENCH_CHAIN_NODE_SIZE(bench_key_size, data_size));
+        if (!data || !buckets || !nodes) {
+          fprintf(stderr, "out of memory for %llu bytes\n",
+              (unsigned long long)bytes);
+          free(data);
+          free(buckets);
+          free(nodes);
+          continue;
+        }
+
+        for (l = 0; l < sizeof(bench_loads) / sizeof(bench_loads[0]); l++)
+        {
+          count = (uint32_t)((uint64_t)entries * bench_loads[l] / 100);
+          if (!count) {
+            continue;
+          }
+
+          if (!bench_ht(entries, count, data_size, data, &ht_result) ||
+              !bench_chain(entries, count, data_size, buckets, nodes,
+              &chain_result)) {
+            fprintf(stderr, "unexpected result for %u entries\n", entries);
+            failed = 1;
+            break;
+          }
+
+          printf("%s  {\"bytes\": %llu, \"entries\": %u, \"key_size\": %u, "
+              "\"data_size\": %u, \"load\": %u, \"count\": %u, "
+              "\"probe\": \"%s\", \"weak\": %u, ",
+              first ? "" : ",\n", (unsigned long long)bytes, entries,
+              bench_key_size, data_size, bench_loads[l], count,
+              bench_probe_names[bench_probe], bench_weak);
+          bench_print("ht", &ht_result);
+          printf(", ");
+          bench_print("chain", &chain_result);
+          printf("}");
+          fflush(stdout);
+          first = 0;
+        }
+
+        free(data);
+        free(buckets);
+        free(nodes);
+      }
+    }
+  }
+
+  if (failed) {
+    printf("\n], \"error\": \"unexpected result for %u entries\"}\n",
+        entries);
+  } else {
+    printf("\n]}\n");
+  }
+
+  return (failed);
+}
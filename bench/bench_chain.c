@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file bench_chain.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "bench_chain.h"
+
+
+uint8_t bench_chain_init(bench_chain_t *chain, hash_function_t hash_function,
+    uint32_t size, bench_chain_node_t **buckets, uint8_t *nodes,
+    uint32_t count, uint32_t key_size, uint32_t data_size)
+{
+  uint32_t i;
+  bench_chain_node_t *node;
+
+  if (!size) {
+    return (0);
+  }
+
+  chain->hash_function = hash_function;
+  chain->buckets = buckets;
+  chain->free_nodes = NULL;
+  chain->size = size;
+  chain->key_size = key_size;
+  chain->data_size = data_size;
+
+  memset(buckets, 0, (size_t)size * sizeof(bench_chain_node_t *));
+
+  /* Free list in buffer order so the first items are allocated together */
+  for (i = count; i > 0; i--)
+  {
+    node = (bench_chain_node_t *)(nodes + (size_t)(i - 1) *
+        BENCH_CHAIN_NODE_SIZE(key_size, data_size));
+    node->next = chain->free_nodes;
+    chain->free_nodes = node;
+  }
+
+  return (1);
+}
+
+
+uint8_t bench_chain_insert(bench_chain_t *chain, uint8_t *key, uint8_t *data)
+{
+  bench_chain_node_t **bucket;
+  bench_chain_node_t *node;
+
+  bucket = &chain->buckets[chain->hash_function(key) % chain->size];
+
+  for (node = *bucket; node; node = node->next)
+  {
+    if (!memcmp(node + 1, key, chain->key_size)) {
+      return (0);
+    }
+  }
+
+  node = chain->free_nodes;
+  if (!node) {
+    return (0);
+  }
+  chain->free_nodes = node->next;
+
+  memcpy(node + 1, key, chain->key_size);
+  memcpy((uint8_t *)(node + 1) + chain->key_size, data, chain->data_size);
+  node->next = *bucket;
+  *bucket = node;
+
+  return (1);
+}
+
+
+uint8_t bench_chain_get(bench_chain_t *chain, uint8_t *key, uint8_t *data)
+{
+  bench_chain_node_t *node;
+
+  node = chain->buckets[chain->hash_function(key) % chain->size];
+
+  for ( ; node; node = node->next)
+  {
+    if (!memcmp(node + 1, key, chain->key_size)) {
+      memcpy(data, (uint8_t *)(node + 1) + chain->key_size,
+          chain->data_size);
+      return (1);
+    }
+  }
+
+  return (0);
+}
+
+
+uint8_t bench_chain_remove(bench_chain_t *chain, uint8_t *key)
+{
+  bench_chain_node_t **link;
+  bench_chain_node_t *node;
+
+  link = &chain->buckets[chain->hash_function(key) % chain->size];
+
+  for ( ; *link; link = &(*link)->next)
+  {
+    node = *link;
+    if (!memcmp(node + 1, key, chain->key_size)) {
+      *link = node->next;
+      node->next = chain->free_nodes;
+      chain->free_nodes = node;
+      return (1);
+    }
+  }
+
+  return (0);
+}
@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file bench_chain.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef BENCH_CHAIN_H
+#define BENCH_CHAIN_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Chained hash table node, key and data follow it
+ *
+ */
+typedef struct bench_chain_node {
+  /**
+   * @brief Next node in the bucket or in the free list
+   *
+   */
+  struct bench_chain_node *   next;
+} bench_chain_node_t;
+
+/**
+ * @brief Chained hash table used as the baseline of the benchmarks
+ *
+ */
+typedef struct {
+  /**
+   * @brief Function to get hash from key
+   *
+   */
+  hash_function_t             hash_function;
+
+  /**
+   * @brief First node of each bucket
+   *
+   */
+  bench_chain_node_t **       buckets;
+
+  /**
+   * @brief Nodes not holding an item
+   *
+   */
+  bench_chain_node_t *        free_nodes;
+
+  /**
+   * @brief Number of buckets
+   *
+   */
+  uint32_t                    size;
+
+  /**
+   * @brief Size of the key in bytes
+   *
+   */
+  uint32_t                    key_size;
+
+  /**
+   * @brief Size of the data in bytes
+   *
+   */
+  uint32_t                    data_size;
+} bench_chain_t;
+
+/**
+ * @brief Size in bytes of a node
+ *
+ */
+#define BENCH_CHAIN_NODE_SIZE(key_size, data_size) \
+  ((sizeof(bench_chain_node_t) + (key_size) + (data_size) + 7) & ~(size_t)7)
+
+/**
+ * @brief Function to initialize a chained hash table
+ *
+ * @param[in] chain Chained hash table pointer
+ * @param[in] hash_function Function to get hash from key
+ * @param[in] size Number of buckets
+ * @param[in] buckets Buckets buffer of size pointers
+ * @param[in] nodes Nodes buffer of count BENCH_CHAIN_NODE_SIZE nodes
+ * @param[in] count Maximum number of items
+ * @param[in] key_size Size of the key in bytes
+ * @param[in] data_size Size of the data in bytes
+ * @return uint8_t 1 if the chained hash table was initialized else 0
+ */
+uint8_t bench_chain_init(bench_chain_t *chain, hash_function_t hash_function,
+    uint32_t size, bench_chain_node_t **buckets, uint8_t *nodes,
+    uint32_t count, uint32_t key_size, uint32_t data_size);
+
+/**
+ * @brief Function to insert an item in a chained hash table
+ *
+ * @param[in] chain Chained hash table pointer
+ * @param[in] key Key
+ * @param[in] data Data
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t bench_chain_insert(bench_chain_t *chain, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to get an item from a chained hash table
+ *
+ * @param[in] chain Chained hash table pointer
+ * @param[in] key Key
+ * @param[out] data Data
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t bench_chain_get(bench_chain_t *chain, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to remove an item from a chained hash table
+ *
+ * @param[in] chain Chained hash table pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t bench_chain_remove(bench_chain_t *chain, uint8_t *key);
+
+#endif /* BENCH_CHAIN_H */
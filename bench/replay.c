@@ -0,0 +1,569 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file replay.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "ht.h"
+#include "ht_trace.h"
+#include "bench_chain.h"
+
+/**
+ * @brief Largest data size accepted in a trace
+ *
+ */
+#define REPLAY_DATA_MAX    (1024 * 1024)
+
+/**
+ * @brief Table engine driven by the replay
+ *
+ */
+typedef struct {
+  /**
+   * @brief Name given to -e
+   *
+   */
+  const char *  name;
+
+  /**
+   * @brief Function to create an empty table
+   *
+   */
+  uint8_t       (*init)(void);
+
+  /**
+   * @brief Function to insert an item
+   *
+   */
+  uint8_t       (*insert)(uint8_t *key, uint8_t *data);
+
+  /**
+   * @brief Function to get an item
+   *
+   */
+  uint8_t       (*get)(uint8_t *key, uint8_t *data);
+
+  /**
+   * @brief Function to remove an item
+   *
+   */
+  uint8_t       (*remove)(uint8_t *key, uint8_t *data);
+} replay_engine_t;
+
+/**
+ * @brief Replay configuration
+ *
+ */
+typedef struct {
+  /**
+   * @brief Number of entries or buckets
+   *
+   */
+  uint32_t      size;
+
+  /**
+   * @brief Cache capacity, 0 to disable the cache mode
+   *
+   */
+  uint32_t      capacity;
+
+  /**
+   * @brief Bloom filter blocks, 0 to disable the filter
+   *
+   */
+  uint32_t      bloom_blocks;
+
+  /**
+   * @brief Maximum load in percent, 0 to keep the default
+   *
+   */
+  uint32_t      max_load;
+
+  /**
+   * @brief Size of the keys in bytes, shorter keys are padded with zeros
+   *
+   */
+  uint32_t      key_size;
+
+  /**
+   * @brief Size of the data in bytes
+   *
+   */
+  uint32_t      data_size;
+} replay_config_t;
+
+static replay_config_t replay_config;
+
+static ht_t replay_ht;
+static uint8_t *replay_ht_data;
+static uint64_t *replay_ht_bloom;
+static ht_bloom_t replay_bloom;
+
+static bench_chain_t replay_chain;
+static bench_chain_node_t **replay_chain_buckets;
+static uint8_t *replay_chain_nodes;
+
+
+/**
+ * @brief Function to get hash from a key of replay_config.key_size bytes
+ *
+ * @param key Key
+ * @return uint32_t Hash
+ */
+static uint32_t replay_hash_function(uint8_t *key)
+{
+  uint32_t i;
+  uint32_t hash;
+
+  /* FNV-1a */
+  hash = 2166136261u;
+  for (i = 0; i < replay_config.key_size; i++)
+  {
+    hash ^= key[i];
+    hash *= 16777619u;
+  }
+
+  return (hash);
+}
+
+
+/**
+ * @brief Function to create an empty hash table
+ *
+ * @return uint8_t 1 if the hash table was created else 0
+ */
+static uint8_t replay_ht_init(void)
+{
+  size_t size;
+
+  size = (size_t)replay_config.size * (sizeof(ht_entry_t) +
+      replay_config.key_size + replay_config.data_size);
+
+  free(replay_ht_data);
+  replay_ht_data = calloc(1, size);
+  if (!replay_ht_data) {
+    return (0);
+  }
+
+  ht_init(&replay_ht, replay_hash_function, replay_config.size,
+      replay_config.data_size, replay_config.key_size, replay_ht_data);
+
+  if (replay_config.max_load &&
+      !ht_set_max_load(&replay_ht, replay_config.max_load)) {
+    return (0);
+  }
+
+  if (replay_config.capacity &&
+      !ht_set_cache(&replay_ht, replay_config.capacity, NULL, NULL)) {
+    return (0);
+  }
+
+  if (replay_config.bloom_blocks) {
+    free(replay_ht_bloom);
+    replay_ht_bloom = malloc(HT_BLOOM_WORDS(replay_config.bloom_blocks) *
+        sizeof(uint64_t));
+    if (!replay_ht_bloom ||
+        !ht_bloom_init(&replay_bloom, replay_config.bloom_blocks,
+        replay_ht_bloom) ||
+        !ht_set_bloom(&replay_ht, &replay_bloom)) {
+      return (0);
+    }
+  }
+
+  return (1);
+}
+
+
+static uint8_t replay_ht_insert(uint8_t *key, uint8_t *data)
+{
+  return (ht_insert(&replay_ht, key, data));
+}
+
+
+static uint8_t replay_ht_get(uint8_t *key, uint8_t *data)
+{
+  return (ht_get(&replay_ht, key, data));
+}
+
+
+static uint8_t replay_ht_remove(uint8_t *key, uint8_t *data)
+{
+  return (ht_remove(&replay_ht, key, data));
+}
+
+
+/**
+ * @brief Function to create an empty chained hash table
+ *
+ * @return uint8_t 1 if the chained hash table was created else 0
+ */
+static uint8_t replay_chain_init(void)
+{
+  free(replay_chain_buckets);
+  free(replay_chain_nodes);
+  replay_chain_buckets = malloc((size_t)replay_config.size *
+      sizeof(bench_chain_node_t *));
+  replay_chain_nodes = malloc((size_t)replay_config.size *
+      BENCH_CHAIN_NODE_SIZE(replay_config.key_size, replay_config.data_size));
+  if (!replay_chain_buckets || !replay_chain_nodes) {
+    return (0);
+  }
+
+  return (bench_chain_init(&replay_chain, replay_hash_function,
+         replay_config.size, replay_chain_buckets, replay_chain_nodes,
+         replay_config.size, replay_config.key_size,
+         replay_config.data_size));
+}
+
+
+static uint8_t replay_chain_insert(uint8_t *key, uint8_t *data)
+{
+  return (bench_chain_insert(&replay_chain, key, data));
+}
+
+
+static uint8_t replay_chain_get(uint8_t *key, uint8_t *data)
+{
+  return (bench_chain_get(&replay_chain, key, data));
+}
+
+
+static uint8_t replay_chain_remove(uint8_t *key, uint8_t *data)
+{
+  (void)data;
+
+  return (bench_chain_remove(&replay_chain, key));
+}
+
+
+static const replay_engine_t replay_engines[] =
+{
+  { "ht",    replay_ht_init,    replay_ht_insert,    replay_ht_get,
+    replay_ht_remove },
+  { "chain", replay_chain_init, replay_chain_insert, replay_chain_get,
+    replay_chain_remove },
+};
+
+
+/**
+ * @brief Function to get the monotonic time
+ *
+ * @return uint64_t Time in nanoseconds
+ */
+static inline uint64_t replay_now(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec);
+}
+
+
+/**
+ * @brief Function to open a cache miss counter of the calling thread
+ *
+ * @return int File descriptor or -1 if perf events are not available
+ */
+static int replay_cache_misses_open(void)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return ((int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+
+/**
+ * @brief Function to run one record
+ *
+ * @param engine Table engine
+ * @param record Record
+ * @param key Key buffer of replay_config.key_size bytes
+ * @param data Data buffer of replay_config.data_size bytes
+ * @return uint8_t Result of the operation
+ */
+static inline uint8_t replay_record(const replay_engine_t *engine,
+    ht_trace_record_t *record, uint8_t *key, uint8_t *data)
+{
+  memcpy(key, record->key, record->key_size);
+
+  switch (record->operation) {
+  case HT_TRACE_INSERT:
+    return (engine->insert(key, data));
+  case HT_TRACE_GET:
+    return (engine->get(key, data));
+  case HT_TRACE_REMOVE:
+    return (engine->remove(key, data));
+  default:
+    return (0);
+  }
+}
+
+
+/**
+ * @brief Function to compare two latencies for qsort
+ *
+ * @param a First latency
+ * @param b Second latency
+ * @return int Negative, zero or positive as a is lower, equal or higher
+ */
+static int replay_compare(const void *a, const void *b)
+{
+  uint32_t latency_a;
+  uint32_t latency_b;
+
+  latency_a = *(const uint32_t *)a;
+  latency_b = *(const uint32_t *)b;
+
+  return ((latency_a > latency_b) - (latency_a < latency_b));
+}
+
+
+/**
+ * @brief Function to print the usage
+ *
+ * @param name Program name
+ */
+static void replay_usage(const char *name)
+{
+  fprintf(stderr, "usage: %s [-e ht|chain] [-s size] [-c capacity] "
+      "[-b bloom_blocks] [-l max_load] trace\n", name);
+  fprintf(stderr, "Replays a trace recorded with ht_trace.h and prints "
+      "the throughput, latency percentiles and cache misses as JSON\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  int fd;
+  int option;
+  long file_size;
+  FILE *file;
+  uint8_t *key;
+  uint8_t *data;
+  uint8_t *trace_data;
+  uint32_t *latencies;
+  uint64_t i;
+  uint64_t hits;
+  uint64_t start;
+  uint64_t elapsed;
+  uint64_t inserts;
+  uint64_t records;
+  uint64_t cache_misses;
+  const replay_engine_t *engine;
+  ht_trace_reader_t reader;
+  ht_trace_record_t record;
+
+  engine = &replay_engines[0];
+  memset(&replay_config, 0, sizeof(replay_config));
+
+  while ((option = getopt(argc, argv, "e:s:c:b:l:h")) != -1)
+  {
+    switch (option) {
+    case 'e':
+      for (i = 0; i < sizeof(replay_engines) / sizeof(replay_engines[0]);
+           i++)
+      {
+        if (!strcmp(optarg, replay_engines[i].name)) {
+          break;
+        }
+      }
+      if (i == sizeof(replay_engines) / sizeof(replay_engines[0])) {
+        replay_usage(argv[0]);
+        return (1);
+      }
+      engine = &replay_engines[i];
+      break;
+    case 's':
+      replay_config.size = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'c':
+      replay_config.capacity = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'b':
+      replay_config.bloom_blocks = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      replay_config.max_load = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    default:
+      replay_usage(argv[0]);
+      return (option == 'h' ? 0 : 1);
+    }
+  }
+
+  if (optind + 1 != argc) {
+    replay_usage(argv[0]);
+    return (1);
+  }
+
+  /* Load the whole trace so reading it is not measured */
+  file = fopen(argv[optind], "rb");
+  if (!file || fseek(file, 0, SEEK_END) || (file_size = ftell(file)) < 0 ||
+      fseek(file, 0, SEEK_SET)) {
+    fprintf(stderr, "cannot read %s\n", argv[optind]);
+    return (1);
+  }
+  trace_data = malloc(file_size ? (size_t)file_size : 1);
+  if (!trace_data ||
+      fread(trace_data, 1, (size_t)file_size, file) != (size_t)file_size) {
+    fprintf(stderr, "cannot read %s\n", argv[optind]);
+    return (1);
+  }
+  fclose(file);
+
+  if (!ht_trace_reader_init(&reader, trace_data, (uint64_t)file_size)) {
+    fprintf(stderr, "%s is not a trace\n", argv[optind]);
+    return (1);
+  }
+
+  /* Size the keys, the data and the table from the trace */
+  records = 0;
+  inserts = 0;
+  while (ht_trace_reader_next(&reader, &record))
+  {
+    if (record.key_size > replay_config.key_size) {
+      replay_config.key_size = record.key_size;
+    }
+    if (record.data_size > replay_config.data_size) {
+      replay_config.data_size = record.data_size;
+    }
+    inserts += record.operation == HT_TRACE_INSERT;
+    records++;
+  }
+
+  if (!records || replay_config.data_size > REPLAY_DATA_MAX) {
+    fprintf(stderr, "%s has no records or too large data\n", argv[optind]);
+    return (1);
+  }
+
+  if (!replay_config.key_size) {
+    fprintf(stderr, "%s has no record with a key\n", argv[optind]);
+    return (1);
+  }
+
+  if (!replay_config.size) {
+    replay_config.size = inserts > UINT32_MAX / 2 ? UINT32_MAX :
+        (uint32_t)(2 * inserts) + 16;
+  }
+
+  key = calloc(1, replay_config.key_size);
+  data = calloc(1, replay_config.data_size ? replay_config.data_size : 1);
+  latencies = malloc(records * sizeof(uint32_t));
+  if (!key || !data || !latencies) {
+    fprintf(stderr, "out of memory\n");
+    return (1);
+  }
+
+  /* Throughput and cache misses of the whole trace */
+  if (!engine->init()) {
+    fprintf(stderr, "cannot create the %s table\n", engine->name);
+    return (1);
+  }
+
+  fd = replay_cache_misses_open();
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  hits = 0;
+  ht_trace_reader_init(&reader, trace_data, (uint64_t)file_size);
+  start = replay_now();
+  while (ht_trace_reader_next(&reader, &record))
+  {
+    memset(key, 0, replay_config.key_size);
+    hits += replay_record(engine, &record, key, data);
+  }
+  elapsed = replay_now() - start;
+
+  cache_misses = 0;
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &cache_misses, sizeof(cache_misses)) !=
+        sizeof(cache_misses)) {
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  /* Latency of each record, timing adds its own overhead */
+  if (!engine->init()) {
+    fprintf(stderr, "cannot create the %s table\n", engine->name);
+    return (1);
+  }
+
+  ht_trace_reader_init(&reader, trace_data, (uint64_t)file_size);
+  for (i = 0; ht_trace_reader_next(&reader, &record); i++)
+  {
+    memset(key, 0, replay_config.key_size);
+    start = replay_now();
+    replay_record(engine, &record, key, data);
+    latencies[i] = (uint32_t)(replay_now() - start);
+  }
+  qsort(latencies, records, sizeof(uint32_t), replay_compare);
+
+  printf("{\"engine\": \"%s\", \"size\": %u, \"key_size\": %u, "
+      "\"data_size\": %u, \"operations\": %llu, \"hits\": %llu, "
+      "\"seconds\": %.6f, \"operations_per_second\": %.0f, ",
+      engine->name, replay_config.size, replay_config.key_size,
+      replay_config.data_size, (unsigned long long)records,
+      (unsigned long long)hits, (double)elapsed / 1e9,
+      elapsed ? (double)records * 1e9 / (double)elapsed : 0.0);
+  printf("\"latency_ns\": {\"p50\": %u, \"p90\": %u, \"p99\": %u, "
+      "\"p999\": %u, \"max\": %u}, ", latencies[records * 50 / 100],
+      latencies[records * 90 / 100], latencies[records * 99 / 100],
+      latencies[records * 999 / 1000], latencies[records - 1]);
+  if (fd >= 0) {
+    printf("\"cache_misses\": %llu}\n", (unsigned long long)cache_misses);
+    close(fd);
+  } else {
+    printf("\"cache_misses\": null}\n");
+  }
+
+  return (0);
+}
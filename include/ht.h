@@ -34,6 +34,15 @@
 
 #include <stdint.h>
 
+#include "ht_bloom.h"
+#include "ht_sketch.h"
+
+/**
+ * @brief Number of bits of the generation kept in each entry
+ *
+ */
+#define HT_GENERATION_BITS    5
+
 /**
  * @brief Hash entry struct
  *
@@ -44,6 +53,24 @@ typedef struct {
    *
    */
   uint8_t used : 1;
+
+  /**
+   * @brief Indicates if entry held an item that was removed
+   *
+   */
+  uint8_t deleted : 1;
+
+  /**
+   * @brief Generation of the hash_table when the entry was written
+   *
+   */
+  uint8_t generation : HT_GENERATION_BITS;
+
+  /**
+   * @brief Indicates if entry was read since the eviction clock last passed
+   *
+   */
+  uint8_t referenced : 1;
 } ht_entry_t;
 
 /**
@@ -52,6 +79,103 @@ typedef struct {
  */
 typedef uint32_t (*hash_function_t) (uint8_t *key);
 
+/**
+ * @brief Seeded hash callback, different seeds should give unrelated hashes
+ *
+ */
+typedef uint32_t (*ht_seeded_hash_function_t) (uint8_t *key, uint64_t seed);
+
+/**
+ * @brief Seed callback, returns a new random seed
+ *
+ */
+typedef uint64_t (*ht_seed_function_t) (void);
+
+/**
+ * @brief Clock callback used to expire items, in any monotonic unit
+ *
+ */
+typedef uint32_t (*ht_clock_function_t) (void);
+
+/**
+ * @brief Eviction callback, called with the item about to be evicted
+ *
+ */
+typedef void (*ht_evict_function_t) (uint8_t *key, uint8_t *data,
+    void *context);
+
+/**
+ * @brief Combine callback, merges delta into the data stored in the table
+ *
+ */
+typedef void (*ht_combine_function_t) (uint8_t *data, uint8_t *delta,
+    uint32_t data_size);
+
+/**
+ * @brief Actions returned by a ht_foreach callback
+ *
+ */
+enum {
+  /**
+   * @brief Keep the item
+   *
+   */
+  HT_FOREACH_KEEP = 0,
+
+  /**
+   * @brief Keep the item, its data was changed in place
+   *
+   */
+  HT_FOREACH_UPDATE,
+
+  /**
+   * @brief Remove the item
+   *
+   */
+  HT_FOREACH_DELETE,
+
+  /**
+   * @brief Keep the item and stop the iteration
+   *
+   */
+  HT_FOREACH_STOP,
+};
+
+/**
+ * @brief Probe sequences, the order in which entries are checked for a key
+ *
+ */
+enum {
+  /**
+   * @brief Next entry, best cache locality but forms primary clusters
+   *
+   */
+  HT_PROBE_LINEAR = 0,
+
+  /**
+   * @brief Triangular numbers away from the first entry, needs a power of
+   * two size to visit every entry
+   *
+   */
+  HT_PROBE_TRIANGULAR,
+
+  /**
+   * @brief Steps of a second hash derived from the hash, needs a power of
+   * two size to visit every entry
+   *
+   */
+  HT_PROBE_DOUBLE,
+};
+
+/**
+ * @brief Function callback for each item visited by ht_foreach
+ *
+ * Key and data point inside the hash table, data may be changed in place.
+ *
+ */
+typedef uint8_t (*ht_foreach_callback_t) (uint8_t *key, uint8_t *data,
+    void *context);
+
 /**
  * @brief Hash struct
  *
@@ -81,6 +205,12 @@ typedef struct {
    */
   uint32_t              count;
 
+  /**
+   * @brief Number of removed entries still part of a probe sequence
+   *
+   */
+  uint32_t              tombstones;
+
   /**
    * @brief Hash data size
    *
@@ -92,8 +222,134 @@ typedef struct {
    *
    */
   uint32_t              key_size;
+
+  /**
+   * @brief Writer sequence counter, odd while the table is being modified
+   *
+   */
+  uint32_t              sequence;
+
+  /**
+   * @brief Occupancy bitmap with one bit per entry, may be NULL
+   *
+   */
+  uint64_t *            occupancy;
+
+  /**
+   * @brief Current generation, entries of any other generation are empty
+   *
+   */
+  uint8_t               generation;
+
+  /**
+   * @brief Expiry time of each entry, 0 if it never expires, may be NULL
+   *
+   */
+  uint32_t *            expiry;
+
+  /**
+   * @brief Clock callback used with expiry
+   *
+   */
+  ht_clock_function_t   clock_function;
+
+  /**
+   * @brief Index where the next ht_expire call starts
+   *
+   */
+  uint32_t              expiry_cursor;
+
+  /**
+   * @brief Number of items kept in cache mode, 0 if cache mode is disabled
+   *
+   */
+  uint32_t              capacity;
+
+  /**
+   * @brief Index of the next entry considered for eviction
+   *
+   */
+  uint32_t              clock_hand;
+
+  /**
+   * @brief Eviction callback, may be NULL
+   *
+   */
+  ht_evict_function_t   evict_function;
+
+  /**
+   * @brief Context passed to the eviction callback
+   *
+   */
+  void *                evict_context;
+
+  /**
+   * @brief Frequency sketch used to admit items in cache mode, may be NULL
+   *
+   */
+  ht_sketch_t *         sketch;
+
+  /**
+   * @brief Bloom filter of the keys inserted, may be NULL
+   *
+   */
+  ht_bloom_t *          bloom;
+
+  /**
+   * @brief Largest probe sequence step of an item since the last clear
+   *
+   */
+  uint32_t              max_probe;
+
+  /**
+   * @brief Maximum number of items outside cache mode
+   *
+   */
+  uint32_t              max_count;
+
+  /**
+   * @brief Seeded hash function used instead of hash_function, may be NULL
+   *
+   */
+  ht_seeded_hash_function_t seeded_hash_function;
+
+  /**
+   * @brief Seed passed to the seeded hash function
+   *
+   */
+  uint64_t              seed;
+
+  /**
+   * @brief Function to get a new seed when probes get too long, may be NULL
+   *
+   */
+  ht_seed_function_t    seed_function;
+
+  /**
+   * @brief Probe distance of an insert that makes the hash_table reseed
+   *
+   */
+  uint32_t              reseed_probe;
+
+  /**
+   * @brief Number of times the hash_table was reseeded
+   *
+   */
+  uint32_t              reseeds;
+
+  /**
+   * @brief Probe sequence
+   *
+   */
+  uint32_t              probe;
 } ht_t;
 
+/**
+ * @brief Number of 64 bits words in the occupancy bitmap of a hash_table
+ *
+ */
+#define HT_OCCUPANCY_WORDS(size)    (((size) + 63) / 64)
+
 /**
  * @brief Function to initialize a hash_table
  *
@@ -108,6 +364,25 @@ typedef struct {
 uint8_t ht_init(ht_t *hash_table, hash_function_t hash_function,
     uint32_t size, uint32_t data_size, uint32_t key_size, uint8_t *data);
 
+/**
+ * @brief Function to initialize a hash_table with a probe sequence
+ *
+ * ht_init uses HT_PROBE_LINEAR. Removing an item from a hash_table with
+ * another probe sequence always leaves a tombstone.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash_function Hash function callback
+ * @param[in] size Hash size, a power of two unless probe is HT_PROBE_LINEAR
+ * @param[in] data_size Hash data size
+ * @param[in] key_size Hash key size
+ * @param[in] data Hash table data buffer
+ * @param[in] probe Probe sequence
+ * @return uint8_t 1 if the hash_table was initialized else 0
+ */
+uint8_t ht_init_probe(ht_t *hash_table, hash_function_t hash_function,
+    uint32_t size, uint32_t data_size, uint32_t key_size, uint8_t *data,
+    uint32_t probe);
+
 /**
  * @brief Function to insert an item in the hash_table
  *
@@ -119,6 +394,68 @@ uint8_t ht_init(ht_t *hash_table, hash_function_t hash_function,
 uint8_t ht_insert(ht_t *hash_table, uint8_t *key,
     uint8_t *data);
 
+/**
+ * @brief Function to insert an item that expires in the hash_table
+ *
+ * Once expired the item is reported as missing by ht_get and ht_remove and
+ * its entry is reused by the next insert that probes it. Expired items are
+ * still counted and iterated until their entry is reclaimed.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Item key
+ * @param[in] data Item data
+ * @param[in] ttl Time to live, in the unit of the clock callback
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t ht_insert_ttl(ht_t *hash_table, uint8_t *key,
+    uint8_t *data, uint32_t ttl);
+
+/**
+ * @brief Function to combine a value into an item, inserting it if missing
+ *
+ * The key is looked up once. If the item exists the combine callback
+ * updates its data in place, else the item is inserted with delta as its
+ * data. The built-in callbacks ht_combine_add, ht_combine_min and
+ * ht_combine_max need a hash data size of 1, 2, 4 or 8 bytes, any other
+ * size needs a custom callback.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Item key
+ * @param[in] delta Value to combine, of the hash data size
+ * @param[in] combine_function Combine callback
+ * @return uint8_t 1 if the item was updated or inserted, else 0 if there is
+ * no room for it or a built-in callback does not support the data size
+ */
+uint8_t ht_accumulate(ht_t *hash_table, uint8_t *key, uint8_t *delta,
+    ht_combine_function_t combine_function);
+
+/**
+ * @brief Combine callback adding unsigned integers of 1, 2, 4 or 8 bytes
+ *
+ * @param[in] data Item data
+ * @param[in] delta Value to add
+ * @param[in] data_size Hash data size
+ */
+void ht_combine_add(uint8_t *data, uint8_t *delta, uint32_t data_size);
+
+/**
+ * @brief Combine callback keeping the minimum of unsigned integers
+ *
+ * @param[in] data Item data
+ * @param[in] delta Value to compare
+ * @param[in] data_size Hash data size
+ */
+void ht_combine_min(uint8_t *data, uint8_t *delta, uint32_t data_size);
+
+/**
+ * @brief Combine callback keeping the maximum of unsigned integers
+ *
+ * @param[in] data Item data
+ * @param[in] delta Value to compare
+ * @param[in] data_size Hash data size
+ */
+void ht_combine_max(uint8_t *data, uint8_t *delta, uint32_t data_size);
+
 /**
  * @brief Function to remove an item from the hash_table
  *
@@ -130,16 +467,249 @@ uint8_t ht_insert(ht_t *hash_table, uint8_t *key,
 uint8_t ht_remove(ht_t *hash_table, uint8_t *key,
     uint8_t *data);
 
+/**
+ * @brief Function to remove the item stored in an entry
+ *
+ * Removing an item never moves other items, iterators may call it on the
+ * entry they just returned and carry on.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] index Entry index
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t ht_remove_entry(ht_t *hash_table, uint32_t index, uint8_t *data);
+
 /**
  * @brief Function to get an item from the hash_table
  *
  * @param[in] hash_table Hash pointer
  * @param[in] key Item key
- * @param[out] data Item data
+ * @param[out] data Item data, may be NULL to only check if the item exists
  * @return uint8_t 1 if the item was found else 0
  */
 uint8_t ht_get(ht_t *hash_table, uint8_t *key, uint8_t *data);
 
+/**
+ * @brief Function to get an item from the hash_table without changing it
+ *
+ * Unlike ht_get it neither counts the key in the admission sketch nor gives
+ * the item a second chance in cache mode, so any number of threads may call
+ * it on a hash_table that no thread modifies.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data, may be NULL to only check if the item exists
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_peek(ht_t *hash_table, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to get an item from the hash_table without locking
+ *
+ * Safe to call from any number of reader threads while a single writer
+ * thread calls ht_insert and ht_remove. The reader never writes to the
+ * table; it retries the lookup whenever the writer sequence counter shows
+ * that the table changed while the item was being copied.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_get_optimistic(ht_t *hash_table, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to remove every item from the hash_table
+ *
+ * Moves the hash_table to a new generation, the entries of older
+ * generations are then seen as empty and reused lazily. Each call also
+ * empties one of 2^HT_GENERATION_BITS slices of the entries and of the
+ * occupancy bitmap, so an entry is emptied before its generation comes
+ * back. A call costs 1/2^HT_GENERATION_BITS of zeroing the whole table,
+ * with no call paying for the wrap of the generation.
+ *
+ * @param[in] hash_table Hash pointer
+ * @return uint8_t 1 if the hash_table was cleared else 0
+ */
+uint8_t ht_clear(ht_t *hash_table);
+
+/**
+ * @brief Function to visit every item in the hash_table without copies
+ *
+ * The callback decides from its return value whether each item is kept,
+ * was updated in place or must be removed. Removed items are handled in
+ * the same pass and the other items stay reachable.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] callback Function called for each item
+ * @param[in] context Context passed to the callback
+ * @return uint8_t 1 if every item was visited else 0 if the callback stopped
+ */
+uint8_t ht_foreach(ht_t *hash_table, ht_foreach_callback_t callback,
+    void *context);
+
+/**
+ * @brief Function to attach an occupancy bitmap to the hash_table
+ *
+ * The bitmap is built from the entries already in use and then kept up to
+ * date by ht_insert and ht_remove, iterators use it to jump between used
+ * entries instead of reading every one of them. Bits of entries emptied by
+ * ht_clear are reset one slice per call, iterators skip them meanwhile.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] occupancy Bitmap of HT_OCCUPANCY_WORDS(size) words
+ * @return uint8_t 1 if the bitmap was attached else 0
+ */
+uint8_t ht_set_occupancy(ht_t *hash_table, uint64_t *occupancy);
+
+/**
+ * @brief Function to attach per entry expiry times to the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] expiry Array of size expiry times
+ * @param[in] clock_function Clock callback
+ * @return uint8_t 1 if the expiry times were attached else 0
+ */
+uint8_t ht_set_expiry(ht_t *hash_table, uint32_t *expiry,
+    ht_clock_function_t clock_function);
+
+/**
+ * @brief Function to reclaim expired items
+ *
+ * Checks at most max entries, continuing from where the previous call
+ * stopped, so the cost of expiration can be bounded and spread over time.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] max Maximum number of entries to check
+ * @return uint32_t Number of items reclaimed
+ */
+uint32_t ht_expire(ht_t *hash_table, uint32_t max);
+
+/**
+ * @brief Function to limit the load factor of the hash_table
+ *
+ * Inserting a new item fails once size * percent / 100 items are stored,
+ * keeping probe sequences and misses short. Cache mode uses its capacity
+ * instead.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] percent Maximum load factor in percent, from 1 to 100
+ * @return uint8_t 1 if the limit was set else 0
+ */
+uint8_t ht_set_max_load(ht_t *hash_table, uint32_t percent);
+
+/**
+ * @brief Function to enable the cache mode of the hash_table
+ *
+ * Inserting a new item when capacity items are stored evicts one item,
+ * chosen by the CLOCK algorithm: ht_get marks the items it finds as
+ * referenced and the clock hand gives them a second chance. Keeping the
+ * capacity below the size keeps probe sequences short.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] capacity Maximum number of items, 0 to use the size
+ * @param[in] evict_function Eviction callback, may be NULL
+ * @param[in] context Context passed to the eviction callback
+ * @return uint8_t 1 if the cache mode was enabled else 0
+ */
+uint8_t ht_set_cache(ht_t *hash_table, uint32_t capacity,
+    ht_evict_function_t evict_function, void *context);
+
+/**
+ * @brief Function to attach an admission sketch to a cache mode hash_table
+ *
+ * ht_get and ht_insert record every key they are called with in the
+ * sketch. When the cache is full a new item is only inserted if its key
+ * was seen more often than the key of the item it would evict, so keys
+ * seen once do not push out frequently used items.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] sketch Initialized sketch, NULL to admit every item
+ * @return uint8_t 1 if the sketch was attached else 0
+ */
+uint8_t ht_set_admission(ht_t *hash_table, ht_sketch_t *sketch);
+
+/**
+ * @brief Function to attach a Bloom filter to the hash_table
+ *
+ * The filter is filled with the keys already stored and every inserted key
+ * is added to it. ht_get and ht_remove check it first, so most lookups of
+ * missing keys return without probing the entries. Removed keys stay in
+ * the filter until ht_rebuild_bloom is called.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] bloom Initialized Bloom filter, NULL to detach it
+ * @return uint8_t 1 if the Bloom filter was attached else 0
+ */
+uint8_t ht_set_bloom(ht_t *hash_table, ht_bloom_t *bloom);
+
+/**
+ * @brief Function to rebuild the Bloom filter from the keys stored
+ *
+ * Drops the keys removed since the filter was filled, which brings the
+ * false positive rate back down after many removals.
+ *
+ * @param[in] hash_table Hash pointer
+ * @return uint8_t 1 if the Bloom filter was rebuilt else 0
+ */
+uint8_t ht_rebuild_bloom(ht_t *hash_table);
+
+/**
+ * @brief Function to hash keys with a seed and reseed on long probes
+ *
+ * Rehashes the items in place with the seed. Once set, an insert that
+ * stores an item more than reseed_probe entries away from its first entry
+ * takes a new seed from seed_function and rehashes again. That bounds the
+ * probes of keys crafted to collide under one seed. When the new seed
+ * does not bring the probes under reseed_probe the keys collide under any
+ * seed, or the hash_table is too full, and reseed_probe is doubled.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] seeded_hash_function Seeded hash callback
+ * @param[in] seed Initial seed
+ * @param[in] seed_function Seed callback, NULL to never reseed
+ * @param[in] reseed_probe Probe distance that makes an insert reseed
+ * @return uint8_t 1 if the seeded hash was set else 0
+ */
+uint8_t ht_set_seed(ht_t *hash_table,
+    ht_seeded_hash_function_t seeded_hash_function, uint64_t seed,
+    ht_seed_function_t seed_function, uint32_t reseed_probe);
+
+/**
+ * @brief Function to rehash every item in place with a new seed
+ *
+ * The Bloom filter, the occupancy bitmap, the expiry times and max_probe
+ * follow the items, tombstones are dropped.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] seed New seed
+ * @return uint8_t 1 if the items were rehashed else 0
+ */
+uint8_t ht_reseed(ht_t *hash_table, uint64_t seed);
+
+/**
+ * @brief Function to get the hash of a key in the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Key
+ * @return uint32_t Hash, seeded when a seeded hash function is set
+ */
+static inline uint32_t ht_hash(ht_t *hash_table, uint8_t *key)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to get the entry checked at a step of the probe sequence
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash Hash of the key
+ * @param[in] step Step, 0 is the first entry of the key, below the size
+ * @return uint32_t Entry index
+ */
+static inline uint32_t ht_probe_index(ht_t *hash_table, uint32_t hash,
+    uint32_t step)
+__attribute__((always_inline));
+
 /**
  * @brief Function to get the number of used entries in the hash_table
  *
@@ -149,6 +719,56 @@ uint8_t ht_get(ht_t *hash_table, uint8_t *key, uint8_t *data);
 static inline uint32_t ht_count(ht_t *hash_table)
 __attribute__((always_inline));
 
+/**
+ * @brief Function to get an entry of the hash_table by its index
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] index Entry index
+ * @return ht_entry_t* A pointer to the entry
+ */
+static inline ht_entry_t *ht_entry_get(ht_t *hash_table, uint32_t index)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to check if an entry holds an item
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash_entry Entry pointer
+ * @return uint8_t 1 if the entry holds an item else 0
+ */
+static inline uint8_t ht_entry_used(ht_t *hash_table, ht_entry_t *hash_entry)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to check if an entry held an item that was removed
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash_entry Entry pointer
+ * @return uint8_t 1 if the entry is a tombstone else 0
+ */
+static inline uint8_t ht_entry_deleted(ht_t *hash_table,
+    ht_entry_t *hash_entry)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to mark the start of a modification of the hash_table
+ *
+ * Only needed by callers that change entry data in place while readers use
+ * ht_get_optimistic. Must be paired with ht_write_end.
+ *
+ * @param[in] hash_table Hash pointer
+ */
+static inline void ht_write_begin(ht_t *hash_table)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to mark the end of a modification of the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ */
+static inline void ht_write_end(ht_t *hash_table)
+__attribute__((always_inline));
+
 #include "ht_inline.h"
 
 #endif /* HASH_H */
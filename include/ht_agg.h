@@ -0,0 +1,157 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_agg.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_AGG_H
+#define HT_AGG_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Maximum number of threads used by the merge functions
+ *
+ */
+#define HT_AGG_MAX_THREADS    64
+
+/**
+ * @brief Size in bytes of one record written by ht_agg_collect
+ *
+ */
+#define HT_AGG_RECORD_SIZE(key_size, data_size)    ((key_size) + (data_size))
+
+/**
+ * @brief Parallel aggregation struct
+ *
+ * Aggregation runs in three steps. Each worker combines its rows into its
+ * own tables, one per partition, so workers never share a table. The
+ * partition of a key comes from the high bits of its hash, which keeps
+ * every key of a partition in the same column of tables. The merge then
+ * combines each column into one output table per partition, one thread
+ * per partition.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Local tables, partitions tables per worker, worker major
+   *
+   */
+  ht_t *                        tables;
+
+  /**
+   * @brief Number of workers
+   *
+   */
+  uint32_t                      workers;
+
+  /**
+   * @brief Number of partitions
+   *
+   */
+  uint32_t                      partitions;
+
+  /**
+   * @brief Combine callback used to aggregate and merge
+   *
+   */
+  ht_combine_function_t         combine_function;
+} ht_agg_t;
+
+/**
+ * @brief Function to initialize a parallel aggregation
+ *
+ * Every local table must be initialized with ht_init using the same hash
+ * function, key size and data size, and sized for the distinct keys of one
+ * partition seen by one worker.
+ *
+ * @param[in] agg Aggregation pointer
+ * @param[in] tables Local tables array of workers * partitions tables
+ * @param[in] workers Number of workers
+ * @param[in] partitions Number of partitions
+ * @param[in] combine_function Combine callback
+ * @return uint8_t 1 if the aggregation was initialized else 0
+ */
+uint8_t ht_agg_init(ht_agg_t *agg, ht_t *tables, uint32_t workers,
+    uint32_t partitions, ht_combine_function_t combine_function);
+
+/**
+ * @brief Function to get the partition of a key
+ *
+ * @param[in] agg Aggregation pointer
+ * @param[in] key Item key
+ * @return uint32_t Partition index
+ */
+uint32_t ht_agg_partition(ht_agg_t *agg, uint8_t *key);
+
+/**
+ * @brief Function to aggregate one row in the tables of a worker
+ *
+ * Only the thread of the worker may call it, no locking is done.
+ *
+ * @param[in] agg Aggregation pointer
+ * @param[in] worker Worker index
+ * @param[in] key Row key
+ * @param[in] delta Row value
+ * @return uint8_t 1 if the row was aggregated else 0
+ */
+uint8_t ht_agg_update(ht_agg_t *agg, uint32_t worker, uint8_t *key,
+    uint8_t *delta);
+
+/**
+ * @brief Function to merge the local tables of every partition
+ *
+ * Must be called once every worker is done. Each output table receives
+ * the keys of one partition and they never overlap, so the partitions can
+ * be used independently or flattened with ht_agg_collect.
+ *
+ * @param[in] agg Aggregation pointer
+ * @param[in] outputs Output tables, one per partition, initialized
+ * @param[in] threads Number of threads, at most HT_AGG_MAX_THREADS
+ * @return uint8_t 1 if every partition was merged else 0
+ */
+uint8_t ht_agg_merge(ht_agg_t *agg, ht_t *outputs, uint32_t threads);
+
+/**
+ * @brief Function to copy the merged partitions into one array
+ *
+ * Each partition is copied by one thread to its own slice of the array,
+ * records hold the key followed by the data.
+ *
+ * @param[in] agg Aggregation pointer
+ * @param[in] outputs Output tables given to ht_agg_merge
+ * @param[in] threads Number of threads, at most HT_AGG_MAX_THREADS
+ * @param[out] records Records array, large enough for every merged item
+ * @return uint32_t Number of records written
+ */
+uint32_t ht_agg_collect(ht_agg_t *agg, ht_t *outputs, uint32_t threads,
+    uint8_t *records);
+
+#endif /* HT_AGG_H */
@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_analyze.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_ANALYZE_H
+#define HT_ANALYZE_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Number of key bits flipped by the avalanche test
+ *
+ */
+#define HT_ANALYZE_AVALANCHE_BITS    64
+
+/**
+ * @brief Number of buckets of the cluster length histogram
+ *
+ */
+#define HT_ANALYZE_CLUSTER_BUCKETS   16
+
+/**
+ * @brief Hash function analysis
+ *
+ * Ratios and means are in thousandths. Probe counts include the entry
+ * that ends the search, like the loop of hash_find.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Number of entries of the simulated table
+   *
+   */
+  uint32_t      size;
+
+  /**
+   * @brief Number of keys
+   *
+   */
+  uint32_t      count;
+
+  /**
+   * @brief Chi-square of the keys per entry in thousandths, close to
+   * (size - 1) * 1000 when the hash is uniform
+   *
+   */
+  uint64_t      chi_square;
+
+  /**
+   * @brief Mean fraction of hash bits that change when one key bit
+   * changes, 500 is ideal
+   *
+   */
+  uint32_t      avalanche_mean;
+
+  /**
+   * @brief Largest distance from 500 of the chance that a key bit changes
+   * a hash bit, 0 is ideal and 500 means a hash bit ignores a key bit
+   *
+   */
+  uint32_t      avalanche_bias;
+
+  /**
+   * @brief Expected mean probes to find a stored key with a uniform hash
+   *
+   */
+  uint32_t      probe_hit_expected;
+
+  /**
+   * @brief Mean probes to find a stored key
+   *
+   */
+  uint32_t      probe_hit;
+
+  /**
+   * @brief Expected mean probes to miss a key with a uniform hash
+   *
+   */
+  uint32_t      probe_miss_expected;
+
+  /**
+   * @brief Mean probes to miss a key, over every starting entry
+   *
+   */
+  uint32_t      probe_miss;
+
+  /**
+   * @brief Largest distance of a key from its entry
+   *
+   */
+  uint32_t      max_probe;
+
+  /**
+   * @brief Number of clusters of used entries
+   *
+   */
+  uint32_t      clusters;
+
+  /**
+   * @brief Longest cluster of used entries
+   *
+   */
+  uint32_t      largest_cluster;
+
+  /**
+   * @brief Number of clusters per length, bucket i counts the lengths from
+   * 2^i to 2^(i + 1) - 1
+   *
+   */
+  uint32_t      cluster_histogram[HT_ANALYZE_CLUSTER_BUCKETS];
+} ht_analyze_t;
+
+/**
+ * @brief Function to analyze a hash function over sample keys
+ *
+ * Inserts the keys in a simulated linear probing table of size entries.
+ * The keys should be different, the avalanche test flips their bits in
+ * place and restores them.
+ *
+ * @param[in] hash_function Function to get hash from key
+ * @param[in] keys Keys, count keys of key_size bytes
+ * @param[in] count Number of keys, at most size
+ * @param[in] key_size Size of the key in bytes
+ * @param[in] size Number of entries of the simulated table
+ * @param[in] work Work buffer of size counters
+ * @param[out] analyze Analysis
+ * @return uint8_t 1 if the hash function was analyzed else 0
+ */
+uint8_t ht_analyze(hash_function_t hash_function, uint8_t *keys,
+    uint32_t count, uint32_t key_size, uint32_t size, uint32_t *work,
+    ht_analyze_t *analyze);
+
+#endif /* HT_ANALYZE_H */
@@ -0,0 +1,247 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_atomic.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_ATOMIC_H
+#define HT_ATOMIC_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Size in bytes of one concurrent hash entry for a given key size
+ *
+ * The buffer given to ht_atomic_init must hold size entries of this size
+ * and be aligned to 8 bytes.
+ *
+ */
+#define HT_ATOMIC_ENTRY_SIZE(key_size) \
+  ((sizeof(ht_atomic_entry_t) + (key_size) + 7) & ~((uint32_t)7))
+
+/**
+ * @brief Concurrent hash entry states
+ *
+ * An entry goes from empty to busy when a writer claims it, then moves
+ * between live, deleted and busy. A deleted entry may be claimed again for
+ * another key, which bumps the generation kept above the state so readers
+ * can tell the key changed.
+ *
+ */
+enum {
+  HT_ATOMIC_EMPTY = 0,
+  HT_ATOMIC_BUSY,
+  HT_ATOMIC_LIVE,
+  HT_ATOMIC_DELETED,
+};
+
+/**
+ * @brief Mask of the entry state in the state word
+ */
+#define HT_ATOMIC_STATE_MASK    3
+
+/**
+ * @brief Generation increment in the state word
+ */
+#define HT_ATOMIC_GENERATION    4
+
+/**
+ * @brief Operations applied by ht_atomic_accumulate
+ *
+ */
+enum {
+  HT_ATOMIC_ADD = 0,
+  HT_ATOMIC_MIN,
+  HT_ATOMIC_MAX,
+};
+
+/**
+ * @brief Concurrent hash entry struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Entry state and key generation, updated with compare and swap
+   *
+   */
+  uint32_t      state;
+
+  /**
+   * @brief Number of writers changing the value in place, the entry is not
+   * claimed for another key while pinned
+   *
+   */
+  uint32_t      pins;
+
+  /**
+   * @brief Entry data, up to 8 bytes accessed atomically
+   *
+   */
+  uint64_t      value;
+} ht_atomic_entry_t;
+
+/**
+ * @brief Concurrent hash struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Hash function callback
+   *
+   */
+  hash_function_t       hash_function;
+
+  /**
+   * @brief Hash table data
+   *
+   */
+  uint8_t *             data;
+
+  /**
+   * @brief Hash size
+   *
+   */
+  uint32_t              size;
+
+  /**
+   * @brief Number of live entries
+   *
+   */
+  uint32_t              count;
+
+  /**
+   * @brief Hash data size
+   *
+   */
+  uint32_t              data_size;
+
+  /**
+   * @brief Hash key size
+   *
+   */
+  uint32_t              key_size;
+
+  /**
+   * @brief Size of each entry in data
+   *
+   */
+  uint32_t              entry_size;
+} ht_atomic_t;
+
+/**
+ * @brief Function to initialize a concurrent hash_table
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] hash_function Hash function callback
+ * @param[in] size Hash size
+ * @param[in] data_size Hash data size, at most 8 bytes
+ * @param[in] key_size Hash key size
+ * @param[in] data Hash table data buffer, zeroed and 8 bytes aligned
+ * @return uint8_t 1 if the hash_table was initialized else 0
+ */
+uint8_t ht_atomic_init(ht_atomic_t *hash_table, hash_function_t hash_function,
+    uint32_t size, uint32_t data_size, uint32_t key_size, uint8_t *data);
+
+/**
+ * @brief Function to insert an item in the concurrent hash_table
+ *
+ * May be called by any number of threads. The first deleted entry on the
+ * probe sequence is reused when the key is not in the hash_table.
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] key Item key
+ * @param[in] data Item data
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t ht_atomic_insert(ht_atomic_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to combine a value into an item, inserting it if missing
+ *
+ * Lock-free: any number of threads may accumulate into the same key. The
+ * data of the hash_table must be a uint64_t. A delta applied while another
+ * thread removes the same key may be lost with the removed item.
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] key Item key
+ * @param[in] delta Value to add or compare, inserted if the key is missing
+ * @param[in] operation HT_ATOMIC_ADD, HT_ATOMIC_MIN or HT_ATOMIC_MAX
+ * @return uint8_t 1 if the item was updated or inserted else 0
+ */
+uint8_t ht_atomic_accumulate(ht_atomic_t *hash_table, uint8_t *key,
+    uint64_t delta, uint8_t operation);
+
+/**
+ * @brief Function to remove an item from the concurrent hash_table
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data observed right before the removal, may be NULL
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t ht_atomic_remove(ht_atomic_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to get an item from the concurrent hash_table
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_atomic_get(ht_atomic_t *hash_table, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to replace the data of an item in place
+ *
+ * Like ht_atomic_accumulate it races with a remove of the same key. Data
+ * written while another thread removes the item may be lost with it, and
+ * if the key is inserted again in between, the data may overwrite the new
+ * item while still returning 1.
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @param[in] key Item key
+ * @param[in] data New item data
+ * @return uint8_t 1 if the item was found and updated else 0
+ */
+uint8_t ht_atomic_update(ht_atomic_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to get the number of live entries in the hash_table
+ *
+ * @param[in] hash_table Concurrent hash pointer
+ * @return uint32_t Number of itens in the hash_table
+ */
+uint32_t ht_atomic_count(ht_atomic_t *hash_table);
+
+#endif /* HT_ATOMIC_H */
@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_bloom.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_BLOOM_H
+#define HT_BLOOM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of 64 bits words in a block, one cache line
+ *
+ */
+#define HT_BLOOM_BLOCK_WORDS    8
+
+/**
+ * @brief Number of bits set for each hash
+ *
+ */
+#define HT_BLOOM_HASHES         6
+
+/**
+ * @brief Number of 64 bits words of a filter with the given blocks
+ *
+ */
+#define HT_BLOOM_WORDS(blocks)    ((blocks) * HT_BLOOM_BLOCK_WORDS)
+
+/**
+ * @brief Blocked Bloom filter struct
+ *
+ * Every bit of a hash falls in the same 512 bits block, so a lookup reads
+ * a single cache line. About 10 bits per item, one block per 50 items,
+ * keep false positives around 1%.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Blocks, 64 bytes aligned for one cache line per block
+   *
+   */
+  uint64_t *    blocks;
+
+  /**
+   * @brief Number of blocks
+   *
+   */
+  uint32_t      block_count;
+} ht_bloom_t;
+
+/**
+ * @brief Function to initialize an empty Bloom filter
+ *
+ * @param[in] bloom Bloom filter pointer
+ * @param[in] block_count Number of blocks
+ * @param[in] blocks Buffer of HT_BLOOM_WORDS(block_count) words
+ * @return uint8_t 1 if the Bloom filter was initialized else 0
+ */
+uint8_t ht_bloom_init(ht_bloom_t *bloom, uint32_t block_count,
+    uint64_t *blocks);
+
+/**
+ * @brief Function to add a hash to the Bloom filter
+ *
+ * @param[in] bloom Bloom filter pointer
+ * @param[in] hash Hash of the key
+ */
+void ht_bloom_add(ht_bloom_t *bloom, uint32_t hash);
+
+/**
+ * @brief Function to check if a hash may have been added
+ *
+ * @param[in] bloom Bloom filter pointer
+ * @param[in] hash Hash of the key
+ * @return uint8_t 1 if the hash may have been added, 0 if it was not
+ */
+uint8_t ht_bloom_contains(ht_bloom_t *bloom, uint32_t hash);
+
+/**
+ * @brief Function to remove every hash from the Bloom filter
+ *
+ * @param[in] bloom Bloom filter pointer
+ */
+void ht_bloom_clear(ht_bloom_t *bloom);
+
+#endif /* HT_BLOOM_H */
@@ -0,0 +1,171 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_counters.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_COUNTERS_H
+#define HT_COUNTERS_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of buckets of the latency histograms, bucket i counts the
+ * operations that took from 2^i to 2^(i + 1) - 1 ticks
+ *
+ */
+#define HT_COUNTERS_LATENCY_BUCKETS    32
+
+/**
+ * @brief Operations counted
+ *
+ */
+typedef enum {
+  HT_COUNTERS_INSERT = 0,
+  HT_COUNTERS_GET,
+  HT_COUNTERS_REMOVE,
+  HT_COUNTERS_OPERATIONS
+} ht_counters_operation_t;
+
+/**
+ * @brief Hot path counters of one thread
+ *
+ * Only filled when the library is built with HT_STATS defined, see the
+ * --enable-stats configure option.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Number of calls per operation
+   *
+   */
+  uint64_t      calls[HT_COUNTERS_OPERATIONS];
+
+  /**
+   * @brief Number of calls per operation that returned 1
+   *
+   */
+  uint64_t      hits[HT_COUNTERS_OPERATIONS];
+
+  /**
+   * @brief Number of entry searches
+   *
+   */
+  uint64_t      finds;
+
+  /**
+   * @brief Number of entries checked by the searches
+   *
+   */
+  uint64_t      probes;
+
+  /**
+   * @brief Number of key comparisons made by the searches
+   *
+   */
+  uint64_t      compares;
+
+  /**
+   * @brief Latency histogram per operation, in time stamp counter ticks
+   *
+   */
+  uint64_t      latency[HT_COUNTERS_OPERATIONS][HT_COUNTERS_LATENCY_BUCKETS];
+} ht_counters_t;
+
+#ifdef HT_STATS
+
+/**
+ * @brief Counters of the calling thread
+ *
+ */
+extern _Thread_local ht_counters_t ht_counters_local;
+
+/**
+ * @brief Function to read the time stamp counter
+ *
+ * @return uint64_t Current tick
+ */
+static inline uint64_t ht_counters_tick(void)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to count the end of an operation
+ *
+ * @param[in] operation Operation
+ * @param[in] start Tick when the operation started
+ * @param[in] hit 1 if the operation returned 1 else 0
+ */
+static inline void ht_counters_operation(ht_counters_operation_t operation,
+    uint64_t start, uint8_t hit)
+__attribute__((always_inline));
+
+#define HT_COUNTERS_START(start)    uint64_t start = ht_counters_tick()
+#define HT_COUNTERS_STOP(operation, start, hit) \
+  ht_counters_operation((operation), (start), (hit))
+#define HT_COUNTERS_ADD(counter, value) \
+  (ht_counters_local.counter += (value))
+
+#else
+
+#define HT_COUNTERS_START(start)
+#define HT_COUNTERS_STOP(operation, start, hit)
+#define HT_COUNTERS_ADD(counter, value)
+
+#endif /* HT_STATS */
+
+/**
+ * @brief Function to get the counters of the calling thread
+ *
+ * Threads report their own counters, ht_counters_merge sums them.
+ *
+ * @param[out] counters Counters
+ * @return uint8_t 1 if the library counts operations else 0
+ */
+uint8_t ht_counters_get(ht_counters_t *counters);
+
+/**
+ * @brief Function to reset the counters of the calling thread
+ *
+ * @return uint8_t 1 if the library counts operations else 0
+ */
+uint8_t ht_counters_reset(void);
+
+/**
+ * @brief Function to add counters to a total
+ *
+ * @param[in,out] total Counters to add to
+ * @param[in] counters Counters added
+ * @return uint8_t Always 1
+ */
+uint8_t ht_counters_merge(ht_counters_t *total, ht_counters_t *counters);
+
+#ifdef HT_STATS
+#include "ht_counters_inline.h"
+#endif /* HT_STATS */
+
+#endif /* HT_COUNTERS_H */
@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_counters_inline.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_COUNTERS_INLINE_H
+#define HT_COUNTERS_INLINE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "ht_counters.h"
+
+/**
+ * @brief Function to read the time stamp counter
+ *
+ * Other architectures count nanoseconds instead of ticks.
+ *
+ * @return uint64_t Current tick
+ */
+static inline uint64_t ht_counters_tick(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return (__builtin_ia32_rdtsc());
+#else
+  struct timespec now;
+
+  timespec_get(&now, TIME_UTC);
+
+  return ((uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec);
+#endif
+}
+
+
+/**
+ * @brief Function to count the end of an operation
+ *
+ * @param[in] operation Operation
+ * @param[in] start Tick when the operation started
+ * @param[in] hit 1 if the operation returned 1 else 0
+ */
+static inline void ht_counters_operation(ht_counters_operation_t operation,
+    uint64_t start, uint8_t hit)
+{
+  uint32_t bucket;
+  uint64_t ticks;
+
+  ticks = ht_counters_tick() - start;
+
+  /* Position of the highest bit set */
+  bucket = ticks ? 63 - (uint32_t)__builtin_clzll(ticks) : 0;
+  if (bucket >= HT_COUNTERS_LATENCY_BUCKETS) {
+    bucket = HT_COUNTERS_LATENCY_BUCKETS - 1;
+  }
+
+  ht_counters_local.calls[operation]++;
+  ht_counters_local.hits[operation] += hit;
+  ht_counters_local.latency[operation][bucket]++;
+}
+
+#endif /* HT_COUNTERS_INLINE_H */
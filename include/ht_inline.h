@@ -35,6 +35,58 @@
 #include <stdint.h>
 #include "ht.h"
 
+/**
+ * @brief Function to get the hash of a key in the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Key
+ * @return uint32_t Hash, seeded when a seeded hash function is set
+ */
+static inline uint32_t ht_hash(ht_t *hash_table, uint8_t *key)
+{
+  if (hash_table->seeded_hash_function) {
+    return (hash_table->seeded_hash_function(key, hash_table->seed));
+  }
+
+  return (hash_table->hash_function(key));
+}
+
+
+/**
+ * @brief Function to get the entry checked at a step of the probe sequence
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash Hash of the key
+ * @param[in] step Step, 0 is the first entry of the key, below the size
+ * @return uint32_t Entry index
+ */
+static inline uint32_t ht_probe_index(ht_t *hash_table, uint32_t hash,
+    uint32_t step)
+{
+  uint32_t second;
+  uint64_t index;
+
+  switch (hash_table->probe) {
+  case HT_PROBE_TRIANGULAR:
+    return ((uint32_t)(hash + ((uint64_t)step * (step + 1)) / 2) &
+           (hash_table->size - 1));
+  case HT_PROBE_DOUBLE:
+    /* Murmur3 finalizer, an odd step visits every entry */
+    second = hash;
+    second ^= second >> 16;
+    second *= 0x85ebca6bu;
+    second ^= second >> 13;
+    second *= 0xc2b2ae35u;
+    second ^= second >> 16;
+    return ((hash + step * (second | 1)) & (hash_table->size - 1));
+  default:
+    index = (uint64_t)(hash % hash_table->size) + step;
+    return ((uint32_t)(index < hash_table->size ? index :
+           index - hash_table->size));
+  }
+}
+
+
 /**
  * @brief Function to get the number of used entries in the hash_table
  *
@@ -47,4 +99,78 @@ static inline uint32_t ht_count(ht_t *hash_table)
 }
 
 
+/**
+ * @brief Function to get an entry of the hash_table by its index
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] index Entry index
+ * @return ht_entry_t* A pointer to the entry
+ */
+static inline ht_entry_t *ht_entry_get(ht_t *hash_table, uint32_t index)
+{
+  return ((ht_entry_t *)(hash_table->data + (uintptr_t)index *
+         (sizeof(ht_entry_t) + hash_table->key_size + hash_table->data_size)));
+}
+
+
+/**
+ * @brief Function to check if an entry holds an item
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash_entry Entry pointer
+ * @return uint8_t 1 if the entry holds an item else 0
+ */
+static inline uint8_t ht_entry_used(ht_t *hash_table, ht_entry_t *hash_entry)
+{
+  return (hash_entry->used &&
+         hash_entry->generation == hash_table->generation);
+}
+
+
+/**
+ * @brief Function to check if an entry held an item that was removed
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] hash_entry Entry pointer
+ * @return uint8_t 1 if the entry is a tombstone else 0
+ */
+static inline uint8_t ht_entry_deleted(ht_t *hash_table,
+    ht_entry_t *hash_entry)
+{
+  return (hash_entry->deleted &&
+         hash_entry->generation == hash_table->generation);
+}
+
+
+/**
+ * @brief Function to mark the start of a modification of the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ */
+static inline void ht_write_begin(ht_t *hash_table)
+{
+  uint32_t sequence;
+
+  /* Make the sequence odd before any entry is touched */
+  sequence = __atomic_load_n(&hash_table->sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&hash_table->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief Function to mark the end of a modification of the hash_table
+ *
+ * @param[in] hash_table Hash pointer
+ */
+static inline void ht_write_end(ht_t *hash_table)
+{
+  uint32_t sequence;
+
+  /* Make the sequence even again once all entry stores are visible */
+  sequence = __atomic_load_n(&hash_table->sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&hash_table->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+
 #endif /* HT_INLINE_H */
@@ -0,0 +1,275 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_int.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_INT_H
+#define HT_INT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Key marking an empty entry, the item with this key is kept aside
+ *
+ */
+#define HT_INT_EMPTY_KEY    0
+
+/**
+ * @brief Integer hash entry struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Item key, HT_INT_EMPTY_KEY if the entry is empty
+   *
+   */
+  uint64_t      key;
+
+  /**
+   * @brief Item value
+   *
+   */
+  uint64_t      value;
+} ht_int_entry_t;
+
+/**
+ * @brief 32 bits integer hash entry struct, half the size of ht_int_entry_t
+ *
+ */
+typedef struct {
+  /**
+   * @brief Item key, HT_INT_EMPTY_KEY if the entry is empty
+   *
+   */
+  uint32_t      key;
+
+  /**
+   * @brief Item value
+   *
+   */
+  uint32_t      value;
+} ht_int32_entry_t;
+
+/**
+ * @brief Integer hash struct
+ *
+ * Specialized table for 64 bits integer keys with no entry header: an
+ * entry is empty when its key is HT_INT_EMPTY_KEY. Removal shifts the
+ * following items back, so there are no tombstones. Keys and values that
+ * fit in 32 bits are better stored in a ht_int32_t.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Entries array
+   *
+   */
+  ht_int_entry_t *      entries;
+
+  /**
+   * @brief Hash size minus one, the size is a power of two
+   *
+   */
+  uint32_t              mask;
+
+  /**
+   * @brief Number of items, including the one with the empty key
+   *
+   */
+  uint32_t              count;
+
+  /**
+   * @brief Indicates if the item with the empty key is stored
+   *
+   */
+  uint8_t               empty_key_used;
+
+  /**
+   * @brief Value of the item with the empty key
+   *
+   */
+  uint64_t              empty_key_value;
+} ht_int_t;
+
+/**
+ * @brief 32 bits integer hash struct
+ *
+ * Same as ht_int_t with 8 bytes entries, so twice as many of them fit in a
+ * cache line.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Entries array
+   *
+   */
+  ht_int32_entry_t *    entries;
+
+  /**
+   * @brief Hash size minus one, the size is a power of two
+   *
+   */
+  uint32_t              mask;
+
+  /**
+   * @brief Number of items, including the one with the empty key
+   *
+   */
+  uint32_t              count;
+
+  /**
+   * @brief Indicates if the item with the empty key is stored
+   *
+   */
+  uint8_t               empty_key_used;
+
+  /**
+   * @brief Value of the item with the empty key
+   *
+   */
+  uint32_t              empty_key_value;
+} ht_int32_t;
+
+/**
+ * @brief Function to initialize an integer hash_table
+ *
+ * @param[in] hash_table Integer hash pointer
+ * @param[in] size Hash size, power of two
+ * @param[in] entries Entries array of size entries
+ * @return uint8_t 1 if the hash_table was initialized else 0
+ */
+uint8_t ht_int_init(ht_int_t *hash_table, uint32_t size,
+    ht_int_entry_t *entries);
+
+/**
+ * @brief Function to mix an integer key into a hash
+ *
+ * @param[in] key Item key
+ * @return uint64_t Hash of the key
+ */
+uint64_t ht_int_hash(uint64_t key);
+
+/**
+ * @brief Function to insert an item in the integer hash_table
+ *
+ * @param[in] hash_table Integer hash pointer
+ * @param[in] key Item key
+ * @param[in] value Item value
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t ht_int_insert(ht_int_t *hash_table, uint64_t key, uint64_t value);
+
+/**
+ * @brief Function to remove an item from the integer hash_table
+ *
+ * @param[in] hash_table Integer hash pointer
+ * @param[in] key Item key
+ * @param[out] value Item value, may be NULL
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t ht_int_remove(ht_int_t *hash_table, uint64_t key, uint64_t *value);
+
+/**
+ * @brief Function to get an item from the integer hash_table
+ *
+ * @param[in] hash_table Integer hash pointer
+ * @param[in] key Item key
+ * @param[out] value Item value, may be NULL
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_int_get(ht_int_t *hash_table, uint64_t key, uint64_t *value);
+
+/**
+ * @brief Function to get the number of items in the integer hash_table
+ *
+ * @param[in] hash_table Integer hash pointer
+ * @return uint32_t Number of itens in the hash_table
+ */
+uint32_t ht_int_count(ht_int_t *hash_table);
+
+/**
+ * @brief Function to initialize a 32 bits integer hash_table
+ *
+ * @param[in] hash_table 32 bits integer hash pointer
+ * @param[in] size Hash size, power of two
+ * @param[in] entries Entries array of size entries
+ * @return uint8_t 1 if the hash_table was initialized else 0
+ */
+uint8_t ht_int32_init(ht_int32_t *hash_table, uint32_t size,
+    ht_int32_entry_t *entries);
+
+/**
+ * @brief Function to mix a 32 bits integer key into a hash
+ *
+ * @param[in] key Item key
+ * @return uint32_t Hash of the key
+ */
+uint32_t ht_int32_hash(uint32_t key);
+
+/**
+ * @brief Function to insert an item in the 32 bits integer hash_table
+ *
+ * @param[in] hash_table 32 bits integer hash pointer
+ * @param[in] key Item key
+ * @param[in] value Item value
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t ht_int32_insert(ht_int32_t *hash_table, uint32_t key, uint32_t value);
+
+/**
+ * @brief Function to remove an item from the 32 bits integer hash_table
+ *
+ * @param[in] hash_table 32 bits integer hash pointer
+ * @param[in] key Item key
+ * @param[out] value Item value, may be NULL
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t ht_int32_remove(ht_int32_t *hash_table, uint32_t key,
+    uint32_t *value);
+
+/**
+ * @brief Function to get an item from the 32 bits integer hash_table
+ *
+ * @param[in] hash_table 32 bits integer hash pointer
+ * @param[in] key Item key
+ * @param[out] value Item value, may be NULL
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_int32_get(ht_int32_t *hash_table, uint32_t key, uint32_t *value);
+
+/**
+ * @brief Function to get the number of items in the 32 bits integer
+ * hash_table
+ *
+ * @param[in] hash_table 32 bits integer hash pointer
+ * @return uint32_t Number of itens in the hash_table
+ */
+uint32_t ht_int32_count(ht_int32_t *hash_table);
+
+#endif /* HT_INT_H */
@@ -47,6 +47,12 @@ typedef struct {
    */
   uint32_t      current;
 
+  /**
+   * @brief Index where the iteration stops
+   *
+   */
+  uint32_t      end;
+
   /**
    * @brief Pointer to the hash table
    *
@@ -54,6 +60,21 @@ typedef struct {
   ht_t *        hash_table;
 } ht_iter_t;
 
+/**
+ * @brief Maximum number of threads used by ht_parallel_foreach
+ *
+ */
+#define HT_ITER_MAX_THREADS    64
+
+/**
+ * @brief Function callback for each item visited by ht_parallel_foreach
+ *
+ * Key and data point inside the hash table, they are not copied.
+ *
+ */
+typedef void (*ht_iter_callback_t) (uint8_t *key, uint8_t *data,
+    uint32_t part, void *context);
+
 /**
  * @brief Function to initialize a hash table iterator
  *
@@ -64,6 +85,21 @@ typedef struct {
 uint8_t ht_iter_init(ht_iter_t *ht_iterator,
     ht_t *hash_table);
 
+/**
+ * @brief Function to initialize a hash table iterator over one part
+ *
+ * Splits the entries in parts disjoint ranges of about the same size, the
+ * iterators of different parts can be used concurrently.
+ *
+ * @param[in] ht_iterator Hash table iterator pointer
+ * @param[in] hash_table Hash table pointer
+ * @param[in] part Index of the range to iterate
+ * @param[in] parts Number of ranges
+ * @return uint8_t 1 if the hash table iterator was initialized else 0
+ */
+uint8_t ht_iter_init_range(ht_iter_t *ht_iterator,
+    ht_t *hash_table, uint32_t part, uint32_t parts);
+
 /**
  * @brief Function to get the next key and data in the hash table
  *
@@ -76,4 +112,20 @@ uint8_t ht_iter_init(ht_iter_t *ht_iterator,
 uint8_t ht_iter_get_next(ht_iter_t *ht_iterator,
     ht_t *hash_table, uint8_t *key, uint8_t *data);
 
+/**
+ * @brief Function to visit every item of the hash table from many threads
+ *
+ * The entries are split in one range per thread, the calling thread
+ * iterates the first range. The hash table must not be modified until
+ * the function returns.
+ *
+ * @param[in] hash_table Hash table pointer
+ * @param[in] threads Number of threads, at most HT_ITER_MAX_THREADS
+ * @param[in] callback Function called for each item with its range index
+ * @param[in] context Context passed to the callback
+ * @return uint8_t 1 if every item was visited else 0
+ */
+uint8_t ht_parallel_foreach(ht_t *hash_table, uint32_t threads,
+    ht_iter_callback_t callback, void *context);
+
 #endif /* HT_ITER_H */
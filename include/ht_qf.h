@@ -0,0 +1,183 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_qf.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_QF_H
+#define HT_QF_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Number of metadata bits stored with each remainder
+ *
+ */
+#define HT_QF_METADATA_BITS    3
+
+/**
+ * @brief Number of 64 bits words needed by a quotient filter
+ *
+ * One extra word lets a slot be read across two words without a check.
+ *
+ */
+#define HT_QF_WORDS(quotient_bits, remainder_bits) \
+  (((((uint64_t)1 << (quotient_bits)) * \
+  ((remainder_bits) + HT_QF_METADATA_BITS)) + 63) / 64 + 1)
+
+/**
+ * @brief Function callback for each fingerprint visited by ht_qf_foreach
+ *
+ */
+typedef void (*ht_qf_callback_t) (uint32_t fingerprint, void *context);
+
+/**
+ * @brief Quotient filter struct
+ *
+ * Membership only companion of a hash table storing a fingerprint of the
+ * key hash instead of the key. The high quotient_bits of the fingerprint
+ * select a slot, only the remainder_bits below them are stored along with
+ * three metadata bits, so a slot takes remainder_bits + 3 bits. A lookup
+ * of a key never inserted succeeds with a probability of about
+ * 2^-remainder_bits.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Hash function callback
+   *
+   */
+  hash_function_t       hash_function;
+
+  /**
+   * @brief Packed slots
+   *
+   */
+  uint64_t *            slots;
+
+  /**
+   * @brief Number of quotient bits, there are 2^quotient_bits slots
+   *
+   */
+  uint32_t              quotient_bits;
+
+  /**
+   * @brief Number of remainder bits
+   *
+   */
+  uint32_t              remainder_bits;
+
+  /**
+   * @brief Number of slots
+   *
+   */
+  uint32_t              size;
+
+  /**
+   * @brief Number of fingerprints stored, copies included
+   *
+   */
+  uint32_t              count;
+} ht_qf_t;
+
+/**
+ * @brief Function to initialize a quotient filter
+ *
+ * @param[in] qf Quotient filter pointer
+ * @param[in] hash_function Hash function callback
+ * @param[in] quotient_bits Number of quotient bits
+ * @param[in] remainder_bits Number of remainder bits, at most 32 with the
+ * quotient bits
+ * @param[in] slots Buffer of HT_QF_WORDS(quotient_bits, remainder_bits) words
+ * @return uint8_t 1 if the quotient filter was initialized else 0
+ */
+uint8_t ht_qf_init(ht_qf_t *qf, hash_function_t hash_function,
+    uint32_t quotient_bits, uint32_t remainder_bits, uint64_t *slots);
+
+/**
+ * @brief Function to insert a key in the quotient filter
+ *
+ * @param[in] qf Quotient filter pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the fingerprint of the key was inserted else 0 if the
+ * filter is full
+ */
+uint8_t ht_qf_insert(ht_qf_t *qf, uint8_t *key);
+
+/**
+ * @brief Function to check if a key may be in the quotient filter
+ *
+ * @param[in] qf Quotient filter pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the key may be in the filter, 0 if it is not
+ */
+uint8_t ht_qf_contains(ht_qf_t *qf, uint8_t *key);
+
+/**
+ * @brief Function to remove a key from the quotient filter
+ *
+ * Every insert stores a copy of the fingerprint, even if the same one is
+ * already there, and every remove deletes exactly one copy. Keys sharing a
+ * fingerprint stay contained until each of them was removed. Removing a key
+ * that was never inserted may delete the copy of another key.
+ *
+ * @param[in] qf Quotient filter pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the fingerprint of the key was removed else 0
+ */
+uint8_t ht_qf_remove(ht_qf_t *qf, uint8_t *key);
+
+/**
+ * @brief Function to get the number of fingerprints in the quotient filter
+ *
+ * @param[in] qf Quotient filter pointer
+ * @return uint32_t Number of fingerprints
+ */
+uint32_t ht_qf_count(ht_qf_t *qf);
+
+/**
+ * @brief Function to visit every fingerprint in increasing order
+ *
+ * @param[in] qf Quotient filter pointer
+ * @param[in] callback Function called with each fingerprint
+ * @param[in] context Context passed to the callback
+ */
+void ht_qf_foreach(ht_qf_t *qf, ht_qf_callback_t callback, void *context);
+
+/**
+ * @brief Function to insert every key of a hash_table
+ *
+ * @param[in] qf Quotient filter pointer, using the hash function of the table
+ * @param[in] hash_table Hash pointer
+ * @return uint8_t 1 if every key was inserted else 0
+ */
+uint8_t ht_qf_build(ht_qf_t *qf, ht_t *hash_table);
+
+#endif /* HT_QF_H */
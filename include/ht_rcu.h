@@ -0,0 +1,171 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_rcu.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_RCU_H
+#define HT_RCU_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Read-copy-update reader struct
+ *
+ * Each reader thread owns one of these, padded to a cache line so that
+ * entering and leaving a read section never touches shared lines.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Epoch observed when the read section started, 0 when quiescent
+   *
+   */
+  uint64_t      epoch;
+
+  /**
+   * @brief Padding up to a cache line
+   *
+   */
+  uint8_t       reserved[56];
+} __attribute__((aligned(64))) ht_rcu_reader_t;
+
+/**
+ * @brief Read-copy-update hash struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Published hash table
+   *
+   */
+  ht_t *                current;
+
+  /**
+   * @brief Publication epoch
+   *
+   */
+  uint64_t              epoch;
+
+  /**
+   * @brief Readers array
+   *
+   */
+  ht_rcu_reader_t *     readers;
+
+  /**
+   * @brief Number of readers
+   *
+   */
+  uint32_t              reader_count;
+} ht_rcu_t;
+
+/**
+ * @brief Function to initialize a read-copy-update hash
+ *
+ * @param[in] rcu Read-copy-update hash pointer
+ * @param[in] hash_table Hash table published first
+ * @param[in] readers Readers array, one per reader thread
+ * @param[in] reader_count Number of readers
+ * @return uint8_t 1 if the read-copy-update hash was initialized else 0
+ */
+uint8_t ht_rcu_init(ht_rcu_t *rcu, ht_t *hash_table, ht_rcu_reader_t *readers,
+    uint32_t reader_count);
+
+/**
+ * @brief Function to enter a read section
+ *
+ * The returned hash table stays valid until ht_rcu_read_unlock is called
+ * by the same reader. It must only be read, never modified, so look items
+ * up with ht_peek since ht_get changes tables in cache mode or with an
+ * admission sketch.
+ *
+ * @param[in] rcu Read-copy-update hash pointer
+ * @param[in] reader Reader index
+ * @return ht_t* The published hash table
+ */
+static inline ht_t *ht_rcu_read_lock(ht_rcu_t *rcu, uint32_t reader)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to leave a read section
+ *
+ * @param[in] rcu Read-copy-update hash pointer
+ * @param[in] reader Reader index
+ */
+static inline void ht_rcu_read_unlock(ht_rcu_t *rcu, uint32_t reader)
+__attribute__((always_inline));
+
+/**
+ * @brief Function to get an item from the published hash table
+ *
+ * @param[in] rcu Read-copy-update hash pointer
+ * @param[in] reader Reader index
+ * @param[in] key Item key
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_rcu_get(ht_rcu_t *rcu, uint32_t reader, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to publish a new hash table
+ *
+ * Swaps the published hash table and waits until every reader that could
+ * still see the previous one left its read section. The previous table and
+ * its buffer can be freed or rebuilt as soon as this function returns.
+ * Only one thread may publish at a time.
+ *
+ * @param[in] rcu Read-copy-update hash pointer
+ * @param[in] hash_table Hash table to publish
+ * @return ht_t* The previously published hash table
+ */
+ht_t *ht_rcu_publish(ht_rcu_t *rcu, ht_t *hash_table);
+
+static inline ht_t *ht_rcu_read_lock(ht_rcu_t *rcu, uint32_t reader)
+{
+  uint64_t epoch;
+
+  /* Announce the epoch before looking at the published table */
+  epoch = __atomic_load_n(&rcu->epoch, __ATOMIC_ACQUIRE);
+  __atomic_store_n(&rcu->readers[reader].epoch, epoch, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  return (__atomic_load_n(&rcu->current, __ATOMIC_ACQUIRE));
+}
+
+
+static inline void ht_rcu_read_unlock(ht_rcu_t *rcu, uint32_t reader)
+{
+  __atomic_store_n(&rcu->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+
+#endif /* HT_RCU_H */
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_set.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_SET_H
+#define HT_SET_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief States of a set entry, 2 bits per entry in the control bitmap
+ *
+ */
+enum {
+  HT_SET_EMPTY = 0,
+  HT_SET_USED,
+  HT_SET_DELETED,
+};
+
+/**
+ * @brief Size in bytes of the control bitmap, padded to keep keys aligned
+ *
+ */
+#define HT_SET_CONTROL_SIZE(size)    ((((size) + 31) / 32) * 8)
+
+/**
+ * @brief Size in bytes of the buffer given to ht_set_init
+ *
+ */
+#define HT_SET_SIZE(size, key_size) \
+  (HT_SET_CONTROL_SIZE(size) + (size) * (key_size))
+
+/**
+ * @brief Hash set struct
+ *
+ * Stores keys only: a bitmap with the state of every entry followed by
+ * the keys, packed with no per entry header.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Hash function callback
+   *
+   */
+  hash_function_t       hash_function;
+
+  /**
+   * @brief Control bitmap, 2 bits per entry
+   *
+   */
+  uint8_t *             control;
+
+  /**
+   * @brief Keys array
+   *
+   */
+  uint8_t *             keys;
+
+  /**
+   * @brief Set size
+   *
+   */
+  uint32_t              size;
+
+  /**
+   * @brief Number of keys
+   *
+   */
+  uint32_t              count;
+
+  /**
+   * @brief Set key size
+   *
+   */
+  uint32_t              key_size;
+} ht_set_t;
+
+/**
+ * @brief Function to initialize a hash set
+ *
+ * @param[in] set Set pointer
+ * @param[in] hash_function Hash function callback
+ * @param[in] size Set size
+ * @param[in] key_size Set key size
+ * @param[in] data Buffer of HT_SET_SIZE(size, key_size) bytes
+ * @return uint8_t 1 if the set was initialized else 0
+ */
+uint8_t ht_set_init(ht_set_t *set, hash_function_t hash_function,
+    uint32_t size, uint32_t key_size, uint8_t *data);
+
+/**
+ * @brief Function to add a key to the set
+ *
+ * @param[in] set Set pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the key was added else 0
+ */
+uint8_t ht_set_add(ht_set_t *set, uint8_t *key);
+
+/**
+ * @brief Function to check if a key is in the set
+ *
+ * @param[in] set Set pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the key is in the set else 0
+ */
+uint8_t ht_set_contains(ht_set_t *set, uint8_t *key);
+
+/**
+ * @brief Function to remove a key from the set
+ *
+ * @param[in] set Set pointer
+ * @param[in] key Key
+ * @return uint8_t 1 if the key was removed else 0
+ */
+uint8_t ht_set_remove(ht_set_t *set, uint8_t *key);
+
+/**
+ * @brief Function to get the number of keys in the set
+ *
+ * @param[in] set Set pointer
+ * @return uint32_t Number of keys in the set
+ */
+uint32_t ht_set_count(ht_set_t *set);
+
+#endif /* HT_SET_H */
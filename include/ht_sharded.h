@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_sharded.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_SHARDED_H
+#define HT_SHARDED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Size in bytes of one queued operation for a given hash
+ *
+ */
+#define HT_SHARDED_MESSAGE_SIZE(key_size, data_size) \
+  (1 + (key_size) + (data_size))
+
+/**
+ * @brief Sharded hash operations carried by the queues
+ *
+ */
+enum {
+  HT_SHARDED_INSERT = 1,
+  HT_SHARDED_REMOVE,
+};
+
+/**
+ * @brief Single producer single consumer queue struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Queue messages buffer
+   *
+   */
+  uint8_t *     data;
+
+  /**
+   * @brief Number of messages in the buffer, power of two
+   *
+   */
+  uint32_t      size;
+
+  /**
+   * @brief Size of each message
+   *
+   */
+  uint32_t      message_size;
+
+  /**
+   * @brief Index of the next message to consume, written by the consumer
+   *
+   */
+  uint32_t      head __attribute__((aligned(64)));
+
+  /**
+   * @brief Index of the next message to produce, written by the producer
+   *
+   */
+  uint32_t      tail __attribute__((aligned(64)));
+} __attribute__((aligned(64))) ht_spsc_t;
+
+/**
+ * @brief Sharded hash struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Shards, each an independently initialized hash table
+   *
+   */
+  ht_t *        shards;
+
+  /**
+   * @brief Number of shards
+   *
+   */
+  uint32_t      shard_count;
+
+  /**
+   * @brief Queues from every producer to every shard owner, may be NULL
+   *
+   */
+  ht_spsc_t *   queues;
+
+  /**
+   * @brief Number of producers
+   *
+   */
+  uint32_t      producer_count;
+
+  /**
+   * @brief Next producer to drain for every shard, may be NULL
+   *
+   */
+  uint32_t *    cursors;
+} ht_sharded_t;
+
+/**
+ * @brief Function to initialize a sharded hash
+ *
+ * Every shard must be initialized with ht_init using the same hash
+ * function, key size and data size. Keys are routed by the high bits of
+ * their hash, the shards keep using the low bits to pick an entry.
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] shards Shards array
+ * @param[in] shard_count Number of shards
+ * @return uint8_t 1 if the sharded hash was initialized else 0
+ */
+uint8_t ht_sharded_init(ht_sharded_t *sharded, ht_t *shards,
+    uint32_t shard_count);
+
+/**
+ * @brief Function to bind a shard buffer to a NUMA node
+ *
+ * Must be called before the buffer is given to ht_init. The buffer must be
+ * page aligned, pages already touched are moved to the node.
+ *
+ * @param[in] data Shard buffer
+ * @param[in] length Shard buffer length
+ * @param[in] node NUMA node
+ * @return uint8_t 1 if the buffer was bound else 0
+ */
+uint8_t ht_sharded_bind(uint8_t *data, size_t length, uint32_t node);
+
+/**
+ * @brief Function to get the shard that owns a key
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] key Item key
+ * @return uint32_t Shard index
+ */
+uint32_t ht_sharded_shard(ht_sharded_t *sharded, uint8_t *key);
+
+/**
+ * @brief Function to insert an item in its shard
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] key Item key
+ * @param[in] data Item data
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+uint8_t ht_sharded_insert(ht_sharded_t *sharded, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to remove an item from its shard
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was removed else 0
+ */
+uint8_t ht_sharded_remove(ht_sharded_t *sharded, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to get an item from its shard
+ *
+ * Uses ht_get_optimistic so it can run on any thread while the shard
+ * owner applies queued operations.
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] key Item key
+ * @param[out] data Item data
+ * @return uint8_t 1 if the item was found else 0
+ */
+uint8_t ht_sharded_get(ht_sharded_t *sharded, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to initialize a single producer single consumer queue
+ *
+ * @param[in] queue Queue pointer
+ * @param[in] data Messages buffer
+ * @param[in] size Number of messages, power of two
+ * @param[in] message_size Size of each message
+ * @return uint8_t 1 if the queue was initialized else 0
+ */
+uint8_t ht_spsc_init(ht_spsc_t *queue, uint8_t *data, uint32_t size,
+    uint32_t message_size);
+
+/**
+ * @brief Function to enable the owner thread mode
+ *
+ * Each shard is then modified only by its owner thread. Other threads
+ * submit inserts and removes through the queue from their producer index
+ * to the shard, queues[producer * shard_count + shard].
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] queues Queues array, producer_count * shard_count initialized
+ * queues with messages of HT_SHARDED_MESSAGE_SIZE
+ * @param[in] producer_count Number of producers
+ * @param[in] cursors Array of shard_count cursors, one per shard owner
+ * @return uint8_t 1 if the owner thread mode was enabled else 0
+ */
+uint8_t ht_sharded_set_queues(ht_sharded_t *sharded, ht_spsc_t *queues,
+    uint32_t producer_count, uint32_t *cursors);
+
+/**
+ * @brief Function to submit an operation to the owner of the key shard
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] producer Producer index of the calling thread
+ * @param[in] operation HT_SHARDED_INSERT or HT_SHARDED_REMOVE
+ * @param[in] key Item key
+ * @param[in] data Item data, ignored for removes
+ * @return uint8_t 1 if the operation was queued else 0 if the queue is full
+ */
+uint8_t ht_sharded_submit(ht_sharded_t *sharded, uint32_t producer,
+    uint8_t operation, uint8_t *key, uint8_t *data);
+
+/**
+ * @brief Function to apply the operations queued for a shard
+ *
+ * Must only be called by the shard owner thread. An operation the shard
+ * refuses, an insert into a full shard or of an existing key or a remove of
+ * a missing key, is counted in failed and dropped from its queue. Keeping
+ * it at the head would stall every operation queued after it. Producers
+ * are served one operation at a time in turn, starting where the previous
+ * drain of the shard stopped, so a busy producer cannot starve the others.
+ *
+ * @param[in] sharded Sharded hash pointer
+ * @param[in] shard Shard index
+ * @param[in] max Maximum number of operations to apply
+ * @param[out] failed Number of operations refused, may be NULL
+ * @return uint32_t Number of operations taken from the queues
+ */
+uint32_t ht_sharded_drain(ht_sharded_t *sharded, uint32_t shard,
+    uint32_t max, uint32_t *failed);
+
+#endif /* HT_SHARDED_H */
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_sketch.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_SKETCH_H
+#define HT_SKETCH_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of rows of the frequency sketch
+ *
+ */
+#define HT_SKETCH_DEPTH    4
+
+/**
+ * @brief Largest frequency a counter can hold
+ *
+ */
+#define HT_SKETCH_MAX      15
+
+/**
+ * @brief Size in bytes of the counters of a sketch, 4 bits per counter
+ *
+ */
+#define HT_SKETCH_SIZE(width)    (HT_SKETCH_DEPTH * (((width) + 1) / 2))
+
+/**
+ * @brief Count-min frequency sketch struct
+ *
+ * Estimates how often a hash was seen with a few bits per counter. Once
+ * enough increments were made every counter is halved so the estimates
+ * follow recent traffic.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Counters, HT_SKETCH_DEPTH rows of width counters
+   *
+   */
+  uint8_t *     counters;
+
+  /**
+   * @brief Number of counters per row
+   *
+   */
+  uint32_t      width;
+
+  /**
+   * @brief Increments since the counters were last halved
+   *
+   */
+  uint32_t      additions;
+
+  /**
+   * @brief Increments after which the counters are halved
+   *
+   */
+  uint32_t      sample_size;
+} ht_sketch_t;
+
+/**
+ * @brief Function to initialize a frequency sketch
+ *
+ * @param[in] sketch Sketch pointer
+ * @param[in] width Number of counters per row
+ * @param[in] counters Counters buffer of HT_SKETCH_SIZE(width) bytes
+ * @return uint8_t 1 if the sketch was initialized else 0
+ */
+uint8_t ht_sketch_init(ht_sketch_t *sketch, uint32_t width,
+    uint8_t *counters);
+
+/**
+ * @brief Function to record one occurrence of a hash
+ *
+ * @param[in] sketch Sketch pointer
+ * @param[in] hash Hash of the key
+ */
+void ht_sketch_increment(ht_sketch_t *sketch, uint32_t hash);
+
+/**
+ * @brief Function to estimate how often a hash was seen
+ *
+ * The estimate never undercounts the recent occurrences of the hash.
+ *
+ * @param[in] sketch Sketch pointer
+ * @param[in] hash Hash of the key
+ * @return uint8_t Estimated frequency, up to HT_SKETCH_MAX
+ */
+uint8_t ht_sketch_estimate(ht_sketch_t *sketch, uint32_t hash);
+
+/**
+ * @brief Function to halve every counter of the sketch
+ *
+ * @param[in] sketch Sketch pointer
+ */
+void ht_sketch_age(ht_sketch_t *sketch);
+
+#endif /* HT_SKETCH_H */
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_stats.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_STATS_H
+#define HT_STATS_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Number of buckets of the probe distance histogram
+ *
+ */
+#define HT_STATS_HISTOGRAM_SIZE    16
+
+/**
+ * @brief Maximum number of threads used by ht_stats_parallel
+ *
+ */
+#define HT_STATS_MAX_THREADS       64
+
+/**
+ * @brief Hash table statistics
+ *
+ * The probe distance of an item is the number of probe sequence steps
+ * between the entry its hash points to and the entry that holds it. Clusters
+ * are runs of adjacent entries whatever the probe sequence.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Number of entries
+   *
+   */
+  uint32_t      size;
+
+  /**
+   * @brief Number of items
+   *
+   */
+  uint32_t      count;
+
+  /**
+   * @brief Number of removed entries that lookups still probe through
+   *
+   */
+  uint32_t      tombstones;
+
+  /**
+   * @brief Items per 1000 entries
+   *
+   */
+  uint32_t      load_factor;
+
+  /**
+   * @brief Sum of the probe distances of every item
+   *
+   */
+  uint64_t      probe_total;
+
+  /**
+   * @brief Mean probe distance in thousandths
+   *
+   */
+  uint32_t      mean_probe;
+
+  /**
+   * @brief Largest probe distance
+   *
+   */
+  uint32_t      max_probe;
+
+  /**
+   * @brief Number of items per probe distance, the last bucket counts
+   * every item at HT_STATS_HISTOGRAM_SIZE - 1 or further
+   *
+   */
+  uint32_t      histogram[HT_STATS_HISTOGRAM_SIZE];
+
+  /**
+   * @brief Longest run of consecutive used or removed entries
+   *
+   */
+  uint32_t      largest_cluster;
+
+  /**
+   * @brief Bytes of the entries holding items
+   *
+   */
+  uint64_t      bytes_used;
+
+  /**
+   * @brief Bytes of the entries and of the attached buffers
+   *
+   */
+  uint64_t      bytes_allocated;
+} ht_stats_t;
+
+/**
+ * @brief Function to compute the statistics of the hash_table
+ *
+ * Scans every entry once, the hash_table must not be modified until the
+ * function returns.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[out] stats Statistics
+ * @return uint8_t 1 if the statistics were computed else 0
+ */
+uint8_t ht_stats(ht_t *hash_table, ht_stats_t *stats);
+
+/**
+ * @brief Function to compute the statistics of the hash_table from many
+ * threads
+ *
+ * The entries are split in one range per thread like ht_parallel_foreach,
+ * the calling thread scans the first range.
+ *
+ * @param[in] hash_table Hash pointer
+ * @param[in] threads Number of threads, at most HT_STATS_MAX_THREADS
+ * @param[out] stats Statistics
+ * @return uint8_t 1 if the statistics were computed else 0
+ */
+uint8_t ht_stats_parallel(ht_t *hash_table, uint32_t threads,
+    ht_stats_t *stats);
+
+#endif /* HT_STATS_H */
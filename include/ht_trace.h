@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_trace.h
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#ifndef HT_TRACE_H
+#define HT_TRACE_H
+
+#include <stdint.h>
+
+#include "ht.h"
+
+/**
+ * @brief Bytes at the start of every trace
+ *
+ */
+#define HT_TRACE_MAGIC          "HTT1"
+#define HT_TRACE_MAGIC_SIZE     4
+
+/**
+ * @brief Size in bytes of a record without its key
+ *
+ * A record is the operation (1 byte), the key size (2 bytes), the data
+ * size (4 bytes), both little endian, and the key bytes.
+ *
+ */
+#define HT_TRACE_HEADER_SIZE    7
+
+/**
+ * @brief Size in bytes of a record
+ *
+ */
+#define HT_TRACE_RECORD_SIZE(key_size) \
+  (HT_TRACE_HEADER_SIZE + (uint32_t)(key_size))
+
+/**
+ * @brief Operations recorded
+ *
+ */
+enum {
+  HT_TRACE_INSERT = 1,
+  HT_TRACE_GET,
+  HT_TRACE_REMOVE,
+};
+
+/**
+ * @brief Function callback to write recorded bytes, returns 1 if every
+ * byte was written else 0
+ *
+ */
+typedef uint8_t (*ht_trace_write_function_t) (uint8_t *data, uint32_t size,
+    void *context);
+
+/**
+ * @brief Trace recorder struct
+ *
+ * Records are collected in a buffer and written when it is full, one
+ * recorder must not be used from many threads at once.
+ *
+ */
+typedef struct {
+  /**
+   * @brief Records not written yet
+   *
+   */
+  uint8_t *                   buffer;
+
+  /**
+   * @brief Size of the buffer in bytes
+   *
+   */
+  uint32_t                    buffer_size;
+
+  /**
+   * @brief Bytes used in the buffer
+   *
+   */
+  uint32_t                    used;
+
+  /**
+   * @brief Function to write the buffer
+   *
+   */
+  ht_trace_write_function_t   write_function;
+
+  /**
+   * @brief Context passed to the write function
+   *
+   */
+  void *                      context;
+
+  /**
+   * @brief Number of records written
+   *
+   */
+  uint64_t                    records;
+
+  /**
+   * @brief Number of records waiting in the buffer
+   *
+   */
+  uint32_t                    pending;
+
+  /**
+   * @brief Number of records lost because they could not be written
+   *
+   */
+  uint64_t                    dropped;
+} ht_trace_t;
+
+/**
+ * @brief Trace record
+ *
+ */
+typedef struct {
+  /**
+   * @brief Operation
+   *
+   */
+  uint8_t       operation;
+
+  /**
+   * @brief Size of the key in bytes
+   *
+   */
+  uint16_t      key_size;
+
+  /**
+   * @brief Size of the data in bytes
+   *
+   */
+  uint32_t      data_size;
+
+  /**
+   * @brief Key, points inside the trace
+   *
+   */
+  uint8_t *     key;
+} ht_trace_record_t;
+
+/**
+ * @brief Trace reader struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Trace bytes
+   *
+   */
+  uint8_t *     data;
+
+  /**
+   * @brief Size of the trace in bytes
+   *
+   */
+  uint64_t      size;
+
+  /**
+   * @brief Offset of the next record
+   *
+   */
+  uint64_t      offset;
+} ht_trace_reader_t;
+
+/**
+ * @brief Function to initialize a trace recorder
+ *
+ * The trace starts with HT_TRACE_MAGIC, written with the first records.
+ *
+ * @param[in] trace Trace recorder pointer
+ * @param[in] buffer Buffer of at least HT_TRACE_MAGIC_SIZE bytes
+ * @param[in] buffer_size Size of the buffer in bytes
+ * @param[in] write_function Function to write the buffer
+ * @param[in] context Context passed to the write function
+ * @return uint8_t 1 if the trace recorder was initialized else 0
+ */
+uint8_t ht_trace_init(ht_trace_t *trace, uint8_t *buffer,
+    uint32_t buffer_size, ht_trace_write_function_t write_function,
+    void *context);
+
+/**
+ * @brief Function to record an operation
+ *
+ * @param[in] trace Trace recorder pointer
+ * @param[in] operation Operation
+ * @param[in] key Key
+ * @param[in] key_size Size of the key in bytes
+ * @param[in] data_size Size of the data in bytes
+ * @return uint8_t 1 if the operation was recorded else 0
+ */
+uint8_t ht_trace_record(ht_trace_t *trace, uint8_t operation, uint8_t *key,
+    uint32_t key_size, uint32_t data_size);
+
+/**
+ * @brief Function to write the records waiting in the buffer
+ *
+ * @param[in] trace Trace recorder pointer
+ * @return uint8_t 1 if the records were written else 0
+ */
+uint8_t ht_trace_flush(ht_trace_t *trace);
+
+/**
+ * @brief Function to record and run ht_insert
+ *
+ * @param[in] trace Trace recorder pointer
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Key
+ * @param[in] data Data
+ * @return uint8_t Result of ht_insert
+ */
+uint8_t ht_trace_insert(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to record and run ht_get
+ *
+ * @param[in] trace Trace recorder pointer
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Key
+ * @param[out] data Data, may be NULL
+ * @return uint8_t Result of ht_get
+ */
+uint8_t ht_trace_get(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to record and run ht_remove
+ *
+ * @param[in] trace Trace recorder pointer
+ * @param[in] hash_table Hash pointer
+ * @param[in] key Key
+ * @param[out] data Data, may be NULL
+ * @return uint8_t Result of ht_remove
+ */
+uint8_t ht_trace_remove(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data);
+
+/**
+ * @brief Function to initialize a trace reader
+ *
+ * @param[in] reader Trace reader pointer
+ * @param[in] data Trace bytes
+ * @param[in] size Size of the trace in bytes
+ * @return uint8_t 1 if the data starts with HT_TRACE_MAGIC else 0
+ */
+uint8_t ht_trace_reader_init(ht_trace_reader_t *reader, uint8_t *data,
+    uint64_t size);
+
+/**
+ * @brief Function to read the next record of a trace
+ *
+ * @param[in] reader Trace reader pointer
+ * @param[out] record Record
+ * @return uint8_t 1 if a complete record was read else 0
+ */
+uint8_t ht_trace_reader_next(ht_trace_reader_t *reader,
+    ht_trace_record_t *record);
+
+#endif /* HT_TRACE_H */
@@ -32,50 +32,110 @@
 #include <string.h>
 
 #include "ht.h"
+#include "ht_counters.h"
+
+
+/**
+ * @brief Function to get the current time when items can expire
+ *
+ * @param hash_table Hash pointer
+ * @return uint32_t Current time or 0 if items never expire
+ */
+static inline uint32_t hash_now(ht_t *hash_table)
+{
+  return (hash_table->expiry ? hash_table->clock_function() : 0);
+}
+
+
+/**
+ * @brief Function to check if the item of an entry expired
+ *
+ * @param hash_table Hash pointer
+ * @param index Entry index
+ * @param now Current time
+ * @return uint8_t 1 if the item expired else 0
+ */
+static inline uint8_t hash_expired(ht_t *hash_table, uint32_t index,
+    uint32_t now)
+{
+  return (hash_table->expiry && hash_table->expiry[index] &&
+         (int32_t)(now - hash_table->expiry[index]) >= 0);
+}
 
 
 /**
  * @brief Function to find an entry in the hash_table
  *
+ * Removed entries and expired items do not stop the search, the first one
+ * seen is returned instead of the empty entry that ends it so it can be
+ * reused. Lookups only need max_probe + 1 probes, no item is further away
+ * from its first entry.
+ *
  * @param hash_table Hash pointer
  * @param key Key
+ * @param hash Hash of the key
+ * @param now Current time
+ * @param probes Maximum number of entries to check
+ * @param[out] hash_index Index of the entry found
+ * @param[out] hash_step Probe sequence step of the entry found
  * @return ht_entry_t* A pointer to the hash table entry found or NULL if not found
  */
-static ht_entry_t *hash_find(ht_t *hash_table, uint8_t *key)
+static ht_entry_t *hash_find(ht_t *hash_table, uint8_t *key, uint32_t hash,
+    uint32_t now, uint32_t probes, uint32_t *hash_index, uint32_t *hash_step)
 {
   uint32_t i;
-  uint32_t index;
-  uint32_t position;
+  uint32_t index = 0;
+  uint32_t free_index = 0;
+  uint32_t free_step = 0;
   uint8_t *hash_entry_key;
   ht_entry_t *hash_entry;
+  ht_entry_t *free_entry = NULL;
 
-  /* Convert hash_table key to index */
-  index = hash_table->hash_function(key) % hash_table->size;
+  HT_COUNTERS_ADD(finds, 1);
 
-  /* Iterate over the entries looking for an empty one starting from the index */
-  for (i = 0; i < hash_table->size; i++)
+  /* Iterate over the entries of the probe sequence looking for an empty one */
+  for (i = 0; i < probes; i++)
   {
-    position = index *
-        (sizeof(ht_entry_t) + hash_table->key_size +
-        hash_table->data_size);
-    hash_entry = (ht_entry_t *)(hash_table->data + position);
+    index = ht_probe_index(hash_table, hash, i);
+    hash_entry = ht_entry_get(hash_table, index);
+    HT_COUNTERS_ADD(probes, 1);
 
-    if (!hash_entry->used) {
-      return (hash_entry);
-    } else {
+    if (ht_entry_used(hash_table, hash_entry)) {
       hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+      HT_COUNTERS_ADD(compares, 1);
 
       /* If entry is used by the same key, clear it and break. */
       if (!memcmp(hash_entry_key, key, hash_table->key_size)) {
+        *hash_index = index;
+        *hash_step = i;
         return (hash_entry);
       }
-    }
 
-    index++;
-    index %= hash_table->size;
+      if (!free_entry && hash_expired(hash_table, index, now)) {
+        free_entry = hash_entry;
+        free_index = index;
+        free_step = i;
+      }
+    } else if (!ht_entry_deleted(hash_table, hash_entry)) {
+      break;
+    } else if (!free_entry) {
+      free_entry = hash_entry;
+      free_index = index;
+      free_step = i;
+    }
   }
 
-  return (NULL);
+  if (free_entry) {
+    *hash_index = free_index;
+    *hash_step = free_step;
+    return (free_entry);
+  } else if (i < probes) {
+    *hash_index = index;
+    *hash_step = i;
+    return (hash_entry);
+  } else {
+    return (NULL);
+  }
 }
 
 
@@ -86,32 +146,761 @@ uint8_t ht_init(ht_t *hash_table, hash_function_t hash_function,
   hash_table->data = data;
   hash_table->size = size;
   hash_table->count = 0;
+  hash_table->tombstones = 0;
   hash_table->data_size = data_size;
   hash_table->key_size = key_size;
+  hash_table->sequence = 0;
+  hash_table->occupancy = NULL;
+  hash_table->generation = 0;
+  hash_table->expiry = NULL;
+  hash_table->clock_function = NULL;
+  hash_table->expiry_cursor = 0;
+  hash_table->capacity = 0;
+  hash_table->clock_hand = 0;
+  hash_table->evict_function = NULL;
+  hash_table->evict_context = NULL;
+  hash_table->sketch = NULL;
+  hash_table->bloom = NULL;
+  hash_table->max_probe = 0;
+  hash_table->max_count = size;
+  hash_table->seeded_hash_function = NULL;
+  hash_table->seed = 0;
+  hash_table->seed_function = NULL;
+  hash_table->reseed_probe = 0;
+  hash_table->reseeds = 0;
+  hash_table->probe = HT_PROBE_LINEAR;
 
   return (1);
 }
 
 
-uint8_t ht_insert(ht_t *hash_table, uint8_t *key, uint8_t *data)
+uint8_t ht_init_probe(ht_t *hash_table, hash_function_t hash_function,
+    uint32_t size, uint32_t data_size, uint32_t key_size, uint8_t *data,
+    uint32_t probe)
+{
+  if (probe > HT_PROBE_DOUBLE) {
+    return (0);
+  }
+
+  /* Only a power of two size makes the other sequences visit every entry */
+  if (probe != HT_PROBE_LINEAR && (!size || (size & (size - 1)))) {
+    return (0);
+  }
+
+  ht_init(hash_table, hash_function, size, data_size, key_size, data);
+  hash_table->probe = probe;
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to empty one slice of the entries and occupancy bitmap
+ *
+ * The table is split in 2^HT_GENERATION_BITS slices of whole bitmap words.
+ * Slice i is emptied when the generation becomes i, so every entry is
+ * emptied before the generation it was written in comes back.
+ *
+ * @param hash_table Hash pointer
+ * @param slice Slice index
+ */
+static void hash_clear_slice(ht_t *hash_table, uint32_t slice)
+{
+  uint32_t i;
+  uint32_t end;
+  uint32_t first;
+  uint32_t last;
+  ht_entry_t *hash_entry;
+
+  first = (uint32_t)(((uint64_t)HT_OCCUPANCY_WORDS(hash_table->size) *
+      slice) >> HT_GENERATION_BITS);
+  last = (uint32_t)(((uint64_t)HT_OCCUPANCY_WORDS(hash_table->size) *
+      (slice + 1)) >> HT_GENERATION_BITS);
+
+  if (hash_table->occupancy) {
+    memset(&hash_table->occupancy[first], 0,
+        (size_t)(last - first) * sizeof(uint64_t));
+  }
+
+  end = last * 64 < hash_table->size ? last * 64 : hash_table->size;
+  for (i = first * 64; i < end; i++)
+  {
+    hash_entry = ht_entry_get(hash_table, i);
+    if (hash_entry->used || hash_entry->deleted) {
+      hash_entry->used = 0;
+      hash_entry->deleted = 0;
+    }
+  }
+}
+
+
+uint8_t ht_clear(ht_t *hash_table)
+{
+  ht_write_begin(hash_table);
+  hash_table->count = 0;
+  hash_table->tombstones = 0;
+  hash_table->max_probe = 0;
+  hash_table->generation =
+      (hash_table->generation + 1) & ((1 << HT_GENERATION_BITS) - 1);
+  hash_clear_slice(hash_table, hash_table->generation);
+
+  if (hash_table->bloom) {
+    ht_bloom_clear(hash_table->bloom);
+  }
+  ht_write_end(hash_table);
+
+  return (1);
+}
+
+
+uint8_t ht_set_expiry(ht_t *hash_table, uint32_t *expiry,
+    ht_clock_function_t clock_function)
+{
+  /* Items already in the hash_table never expire */
+  memset(expiry, 0, (size_t)hash_table->size * sizeof(uint32_t));
+
+  hash_table->expiry = expiry;
+  hash_table->clock_function = clock_function;
+  hash_table->expiry_cursor = 0;
+
+  return (1);
+}
+
+
+uint32_t ht_expire(ht_t *hash_table, uint32_t max)
+{
+  uint32_t i;
+  uint32_t now;
+  uint32_t index;
+  uint32_t count;
+
+  if (!hash_table->expiry) {
+    return (0);
+  }
+
+  count = 0;
+  now = hash_now(hash_table);
+
+  for (i = 0; i < max && i < hash_table->size; i++)
+  {
+    index = hash_table->expiry_cursor;
+    hash_table->expiry_cursor = (index + 1) % hash_table->size;
+
+    if (ht_entry_used(hash_table, ht_entry_get(hash_table, index)) &&
+        hash_expired(hash_table, index, now)) {
+      ht_remove_entry(hash_table, index, NULL);
+      count++;
+    }
+  }
+
+  return (count);
+}
+
+
+uint8_t ht_set_cache(ht_t *hash_table, uint32_t capacity,
+    ht_evict_function_t evict_function, void *context)
+{
+  if (capacity > hash_table->size) {
+    return (0);
+  }
+
+  hash_table->capacity = capacity ? capacity : hash_table->size;
+  hash_table->evict_function = evict_function;
+  hash_table->evict_context = context;
+
+  return (1);
+}
+
+
+uint8_t ht_set_max_load(ht_t *hash_table, uint32_t percent)
+{
+  if (!percent || percent > 100) {
+    return (0);
+  }
+
+  hash_table->max_count = (uint32_t)((uint64_t)hash_table->size * percent /
+      100);
+
+  return (1);
+}
+
+
+uint8_t ht_set_admission(ht_t *hash_table, ht_sketch_t *sketch)
+{
+  hash_table->sketch = sketch;
+
+  return (1);
+}
+
+
+uint8_t ht_set_bloom(ht_t *hash_table, ht_bloom_t *bloom)
+{
+  hash_table->bloom = bloom;
+
+  if (!bloom) {
+    return (1);
+  }
+
+  return (ht_rebuild_bloom(hash_table));
+}
+
+
+uint8_t ht_rebuild_bloom(ht_t *hash_table)
+{
+  uint32_t i;
+  ht_entry_t *hash_entry;
+
+  if (!hash_table->bloom) {
+    return (0);
+  }
+
+  ht_bloom_clear(hash_table->bloom);
+
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_entry_get(hash_table, i);
+    if (ht_entry_used(hash_table, hash_entry)) {
+      ht_bloom_add(hash_table->bloom, ht_hash(hash_table,
+          (uint8_t *)(hash_entry + sizeof(ht_entry_t))));
+    }
+  }
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to swap two entries with their expiry times
+ *
+ * @param hash_table Hash pointer
+ * @param index First entry index
+ * @param other Second entry index
+ */
+static void hash_swap(ht_t *hash_table, uint32_t index, uint32_t other)
+{
+  uint8_t byte;
+  uint8_t *entry;
+  uint8_t *other_entry;
+  uint32_t i;
+  uint32_t expiry;
+
+  entry = (uint8_t *)ht_entry_get(hash_table, index);
+  other_entry = (uint8_t *)ht_entry_get(hash_table, other);
+
+  for (i = 0; i < sizeof(ht_entry_t) + hash_table->key_size +
+       hash_table->data_size; i++)
+  {
+    byte = entry[i];
+    entry[i] = other_entry[i];
+    other_entry[i] = byte;
+  }
+
+  if (hash_table->expiry) {
+    expiry = hash_table->expiry[index];
+    hash_table->expiry[index] = hash_table->expiry[other];
+    hash_table->expiry[other] = expiry;
+  }
+}
+
+
+uint8_t ht_set_seed(ht_t *hash_table,
+    ht_seeded_hash_function_t seeded_hash_function, uint64_t seed,
+    ht_seed_function_t seed_function, uint32_t reseed_probe)
+{
+  if (!seeded_hash_function || (seed_function && !reseed_probe)) {
+    return (0);
+  }
+
+  hash_table->seeded_hash_function = seeded_hash_function;
+  hash_table->seed_function = seed_function;
+  hash_table->reseed_probe = reseed_probe;
+
+  return (ht_reseed(hash_table, seed));
+}
+
+
+uint8_t ht_reseed(ht_t *hash_table, uint64_t seed)
+{
+  uint32_t i;
+  uint32_t hash;
+  uint32_t index;
+  uint32_t distance;
+  ht_entry_t *hash_entry;
+  ht_entry_t *target_entry;
+
+  if (!hash_table->seeded_hash_function) {
+    return (0);
+  }
+
+  ht_write_begin(hash_table);
+  hash_table->seed = seed;
+  hash_table->max_probe = 0;
+  hash_table->tombstones = 0;
+
+  /* Drop the tombstones and mark the items as not placed with deleted */
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_entry_get(hash_table, i);
+    if (ht_entry_used(hash_table, hash_entry)) {
+      hash_entry->deleted = 1;
+    } else {
+      hash_entry->used = 0;
+      hash_entry->deleted = 0;
+    }
+  }
+
+  /*
+   * Place each item at the first entry of its new probe sequence that is
+   * empty or holds an item not placed yet, swapping that item in to be
+   * placed next.
+   */
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_entry_get(hash_table, i);
+
+    while (hash_entry->used && hash_entry->deleted)
+    {
+      hash = ht_hash(hash_table, (uint8_t *)(hash_entry +
+          sizeof(ht_entry_t)));
+      index = ht_probe_index(hash_table, hash, 0);
+      target_entry = ht_entry_get(hash_table, index);
+
+      for (distance = 0; target_entry->used && !target_entry->deleted;
+           distance++)
+      {
+        index = ht_probe_index(hash_table, hash, distance + 1);
+        target_entry = ht_entry_get(hash_table, index);
+      }
+
+      if (distance > hash_table->max_probe) {
+        hash_table->max_probe = distance;
+      }
+
+      if (index != i) {
+        hash_swap(hash_table, i, index);
+      }
+      target_entry->deleted = 0;
+    }
+  }
+
+  if (hash_table->occupancy) {
+    memset(hash_table->occupancy, 0,
+        HT_OCCUPANCY_WORDS(hash_table->size) * sizeof(uint64_t));
+    for (i = 0; i < hash_table->size; i++)
+    {
+      if (ht_entry_used(hash_table, ht_entry_get(hash_table, i))) {
+        hash_table->occupancy[i / 64] |= (uint64_t)1 << (i % 64);
+      }
+    }
+  }
+
+  if (hash_table->bloom) {
+    ht_rebuild_bloom(hash_table);
+  }
+  ht_write_end(hash_table);
+
+  return (1);
+}
+
+
+uint8_t ht_set_occupancy(ht_t *hash_table, uint64_t *occupancy)
+{
+  uint32_t i;
+
+  memset(occupancy, 0,
+      HT_OCCUPANCY_WORDS(hash_table->size) * sizeof(uint64_t));
+
+  /* Mark the entries already in use */
+  for (i = 0; i < hash_table->size; i++)
+  {
+    if (ht_entry_used(hash_table, ht_entry_get(hash_table, i))) {
+      occupancy[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+  }
+
+  hash_table->occupancy = occupancy;
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to evict one item chosen by the CLOCK algorithm
+ *
+ * Referenced items get a second chance, expired items are evicted first.
+ * With an admission sketch the item is kept instead if its key was seen at
+ * least as often as the key of the new item.
+ *
+ * @param hash_table Hash pointer
+ * @param hash Hash of the key of the new item
+ * @param now Current time
+ * @return uint8_t 1 if an item was evicted else 0
+ */
+static uint8_t hash_evict(ht_t *hash_table, uint32_t hash, uint32_t now)
 {
+  uint32_t index;
   ht_entry_t *hash_entry;
   uint8_t *hash_entry_key;
-  uint8_t *hash_entry_data;
 
-  hash_entry = hash_find(hash_table, key);
+  for ( ; ; )
+  {
+    index = hash_table->clock_hand;
+    hash_table->clock_hand = (index + 1) % hash_table->size;
+    hash_entry = ht_entry_get(hash_table, index);
+
+    if (!ht_entry_used(hash_table, hash_entry)) {
+      continue;
+    }
+
+    if (hash_expired(hash_table, index, now)) {
+      break;
+    }
+
+    if (hash_entry->referenced) {
+      hash_entry->referenced = 0;
+      continue;
+    }
 
-  /* Set data and mark as used if empty entry is available */
-  if (hash_entry && !hash_entry->used) {
     hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
-    hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+    if (hash_table->sketch &&
+        ht_sketch_estimate(hash_table->sketch, hash) <=
+        ht_sketch_estimate(hash_table->sketch,
+        ht_hash(hash_table, hash_entry_key))) {
+      return (0);
+    }
 
-    hash_table->count++;
-    hash_entry->used = 1;
-    /* Save key and data */
-    memcpy(hash_entry_key, key, hash_table->key_size);
-    memcpy(hash_entry_data, data, hash_table->data_size);
+    break;
+  }
+
+  if (hash_table->evict_function) {
+    hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+    hash_table->evict_function(hash_entry_key,
+        hash_entry_key + hash_table->key_size, hash_table->evict_context);
+  }
+
+  ht_remove_entry(hash_table, index, NULL);
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to insert an item in the hash_table
+ *
+ * @param hash_table Hash pointer
+ * @param key Item key
+ * @param data Item data
+ * @param now Current time
+ * @param expiry Item expiry time, 0 if it never expires
+ * @param combine_function Combine callback for an existing item, may be NULL
+ * @return uint8_t 1 if the item was inserted or combined else 0
+ */
+static uint8_t hash_insert(ht_t *hash_table, uint8_t *key, uint8_t *data,
+    uint32_t now, uint32_t expiry, ht_combine_function_t combine_function)
+{
+  uint32_t hash;
+  uint32_t index;
+  uint32_t displacement;
+  ht_entry_t *hash_entry;
+  uint8_t *hash_entry_key;
+  uint8_t *hash_entry_data;
+
+  hash = ht_hash(hash_table, key);
+  if (hash_table->sketch) {
+    ht_sketch_increment(hash_table->sketch, hash);
+  }
+
+  hash_entry = hash_find(hash_table, key, hash, now, hash_table->size,
+      &index, &displacement);
+
+  /* A used entry is either the same key or an expired item to reclaim */
+  if (hash_entry && ht_entry_used(hash_table, hash_entry) &&
+      !hash_expired(hash_table, index, now)) {
+    if (!combine_function) {
+      return (0);
+    }
+
+    hash_entry_data = (uint8_t *)(hash_entry + sizeof(ht_entry_t) +
+        hash_table->key_size);
+
+    ht_write_begin(hash_table);
+    combine_function(hash_entry_data, data, hash_table->data_size);
+    ht_write_end(hash_table);
+
+    if (hash_table->capacity && !hash_entry->referenced) {
+      hash_entry->referenced = 1;
+    }
     return (1);
+  }
+
+  /* In cache mode make room for a new item and look for its entry again */
+  if (hash_table->capacity && hash_table->count >= hash_table->capacity &&
+      (!hash_entry || !ht_entry_used(hash_table, hash_entry))) {
+    if (!hash_evict(hash_table, hash, now)) {
+      return (0);
+    }
+    hash_entry = hash_find(hash_table, key, hash, now, hash_table->size,
+        &index, &displacement);
+  }
+
+  if (!hash_entry) {
+    return (0);
+  }
+
+  /* Outside cache mode a new item must not go over the load limit */
+  if (!hash_table->capacity && !ht_entry_used(hash_table, hash_entry) &&
+      hash_table->count >= hash_table->max_count) {
+    return (0);
+  }
+
+  hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+  hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+
+  ht_write_begin(hash_table);
+  if (displacement > hash_table->max_probe) {
+    hash_table->max_probe = displacement;
+  }
+  if (!ht_entry_used(hash_table, hash_entry)) {
+    if (ht_entry_deleted(hash_table, hash_entry)) {
+      hash_table->tombstones--;
+    }
+    hash_table->count++;
+  }
+  hash_entry->used = 1;
+  hash_entry->deleted = 0;
+  hash_entry->referenced = 0;
+  hash_entry->generation = hash_table->generation;
+  /* Save key and data */
+  memcpy(hash_entry_key, key, hash_table->key_size);
+  memcpy(hash_entry_data, data, hash_table->data_size);
+  if (hash_table->occupancy) {
+    hash_table->occupancy[index / 64] |= (uint64_t)1 << (index % 64);
+  }
+  if (hash_table->expiry) {
+    hash_table->expiry[index] = expiry;
+  }
+  if (hash_table->bloom) {
+    ht_bloom_add(hash_table->bloom, hash);
+  }
+  ht_write_end(hash_table);
+
+  /* Keys crafted to collide under one seed do not collide under another */
+  if (hash_table->seed_function && displacement > hash_table->reseed_probe) {
+    ht_reseed(hash_table, hash_table->seed_function());
+    hash_table->reseeds++;
+
+    if (hash_table->max_probe > hash_table->reseed_probe) {
+      hash_table->reseed_probe = hash_table->reseed_probe > UINT32_MAX / 2 ?
+          UINT32_MAX : hash_table->reseed_probe * 2;
+    }
+  }
+
+  return (1);
+}
+
+
+uint8_t ht_insert(ht_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint8_t inserted;
+
+  HT_COUNTERS_START(start);
+  inserted = hash_insert(hash_table, key, data, hash_now(hash_table), 0,
+      NULL);
+  HT_COUNTERS_STOP(HT_COUNTERS_INSERT, start, inserted);
+
+  return (inserted);
+}
+
+
+uint8_t ht_insert_ttl(ht_t *hash_table, uint8_t *key, uint8_t *data,
+    uint32_t ttl)
+{
+  uint32_t now;
+  uint32_t expiry;
+  uint8_t inserted;
+
+  if (!hash_table->expiry) {
+    return (0);
+  }
+
+  HT_COUNTERS_START(start);
+
+  /* 0 is reserved for items that never expire */
+  now = hash_now(hash_table);
+  expiry = now + ttl;
+  if (!expiry) {
+    expiry = 1;
+  }
+
+  inserted = hash_insert(hash_table, key, data, now, expiry, NULL);
+  HT_COUNTERS_STOP(HT_COUNTERS_INSERT, start, inserted);
+
+  return (inserted);
+}
+
+
+/**
+ * @brief Function to check the data size of the built-in combine callbacks
+ *
+ * @param data_size Hash data size
+ * @return uint8_t 1 if the data is an unsigned integer of 1, 2, 4 or 8 bytes
+ * else 0
+ */
+static inline uint8_t hash_combine_size(uint32_t data_size)
+{
+  return (data_size == sizeof(uint8_t) || data_size == sizeof(uint16_t) ||
+         data_size == sizeof(uint32_t) || data_size == sizeof(uint64_t));
+}
+
+
+uint8_t ht_accumulate(ht_t *hash_table, uint8_t *key, uint8_t *delta,
+    ht_combine_function_t combine_function)
+{
+  uint8_t inserted;
+
+  /* The built-in callbacks would leave any other data untouched */
+  if ((combine_function == ht_combine_add ||
+      combine_function == ht_combine_min ||
+      combine_function == ht_combine_max) &&
+      !hash_combine_size(hash_table->data_size)) {
+    return (0);
+  }
+
+  HT_COUNTERS_START(start);
+  inserted = hash_insert(hash_table, key, delta, hash_now(hash_table), 0,
+      combine_function);
+  HT_COUNTERS_STOP(HT_COUNTERS_INSERT, start, inserted);
+
+  return (inserted);
+}
+
+
+/**
+ * @brief Function to load an unsigned integer of 1, 2, 4 or 8 bytes
+ *
+ * @param data Integer pointer
+ * @param data_size Integer size
+ * @return uint64_t Integer value
+ */
+static inline uint64_t hash_combine_load(uint8_t *data, uint32_t data_size)
+{
+  uint8_t value8;
+  uint16_t value16;
+  uint32_t value32;
+  uint64_t value64 = 0;
+
+  switch (data_size) {
+  case sizeof(uint8_t):
+    memcpy(&value8, data, sizeof(value8));
+    return (value8);
+  case sizeof(uint16_t):
+    memcpy(&value16, data, sizeof(value16));
+    return (value16);
+  case sizeof(uint32_t):
+    memcpy(&value32, data, sizeof(value32));
+    return (value32);
+  case sizeof(uint64_t):
+    memcpy(&value64, data, sizeof(value64));
+    return (value64);
+  default:
+    return (0);
+  }
+}
+
+
+/**
+ * @brief Function to store an unsigned integer of 1, 2, 4 or 8 bytes
+ *
+ * @param data Integer pointer
+ * @param data_size Integer size
+ * @param value Integer value, truncated to the integer size
+ */
+static inline void hash_combine_store(uint8_t *data, uint32_t data_size,
+    uint64_t value)
+{
+  uint8_t value8 = (uint8_t)value;
+  uint16_t value16 = (uint16_t)value;
+  uint32_t value32 = (uint32_t)value;
+
+  switch (data_size) {
+  case sizeof(uint8_t):
+    memcpy(data, &value8, sizeof(value8));
+    break;
+  case sizeof(uint16_t):
+    memcpy(data, &value16, sizeof(value16));
+    break;
+  case sizeof(uint32_t):
+    memcpy(data, &value32, sizeof(value32));
+    break;
+  case sizeof(uint64_t):
+    memcpy(data, &value, sizeof(value));
+    break;
+  default:
+    break;
+  }
+}
+
+
+void ht_combine_add(uint8_t *data, uint8_t *delta, uint32_t data_size)
+{
+  hash_combine_store(data, data_size, hash_combine_load(data, data_size) +
+      hash_combine_load(delta, data_size));
+}
+
+
+void ht_combine_min(uint8_t *data, uint8_t *delta, uint32_t data_size)
+{
+  if (hash_combine_load(delta, data_size) <
+      hash_combine_load(data, data_size)) {
+    memcpy(data, delta, data_size);
+  }
+}
+
+
+void ht_combine_max(uint8_t *data, uint8_t *delta, uint32_t data_size)
+{
+  if (hash_combine_load(delta, data_size) >
+      hash_combine_load(data, data_size)) {
+    memcpy(data, delta, data_size);
+  }
+}
+
+
+/**
+ * @brief Function to remove an item from the hash_table
+ *
+ * @param hash_table Hash pointer
+ * @param key Key
+ * @param[out] data Data of the removed item, may be NULL
+ * @return uint8_t 1 if the item was removed else 0
+ */
+static inline uint8_t hash_remove(ht_t *hash_table, uint8_t *key,
+    uint8_t *data)
+{
+  uint32_t now;
+  uint32_t hash;
+  uint32_t index;
+  uint32_t step;
+  ht_entry_t *hash_entry;
+
+  hash = ht_hash(hash_table, key);
+  if (hash_table->bloom && !ht_bloom_contains(hash_table->bloom, hash)) {
+    return (0);
+  }
+
+  now = hash_now(hash_table);
+  hash_entry = hash_find(hash_table, key, hash, now,
+      hash_table->max_probe + 1, &index, &step);
+
+  /* Clear data and mark as removed if entry is found */
+  if (hash_entry && ht_entry_used(hash_table, hash_entry)) {
+    /* An expired item is reclaimed but reported as missing */
+    if (hash_expired(hash_table, index, now)) {
+      ht_remove_entry(hash_table, index, NULL);
+      return (0);
+    }
+
+    return (ht_remove_entry(hash_table, index, data));
   } else {
     return (0);
   }
@@ -119,27 +908,123 @@ uint8_t ht_insert(ht_t *hash_table, uint8_t *key, uint8_t *data)
 
 
 uint8_t ht_remove(ht_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint8_t removed;
+
+  HT_COUNTERS_START(start);
+  removed = hash_remove(hash_table, key, data);
+  HT_COUNTERS_STOP(HT_COUNTERS_REMOVE, start, removed);
+
+  return (removed);
+}
+
+
+uint8_t ht_remove_entry(ht_t *hash_table, uint32_t index, uint8_t *data)
 {
   ht_entry_t *hash_entry;
+  ht_entry_t *next_entry;
   uint8_t *hash_entry_key;
   uint8_t *hash_entry_data;
 
-  hash_entry = hash_find(hash_table, key);
+  hash_entry = ht_entry_get(hash_table, index);
+  if (!ht_entry_used(hash_table, hash_entry)) {
+    return (0);
+  }
 
-  /* Clear data and mark as not used if entry is found */
-  if (hash_entry && hash_entry->used) {
-    hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
-    hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+  hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+  hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+
+  if (data) {
+    /* Copy data */
+    memcpy(data, hash_entry_data, hash_table->data_size);
+  }
+
+  ht_write_begin(hash_table);
+  hash_table->count--;
+  hash_entry->used = 0;
+  memset(hash_entry_key, 0, hash_table->key_size);
+  memset(hash_entry_data, 0, hash_table->data_size);
+  if (hash_table->occupancy) {
+    hash_table->occupancy[index / 64] &= ~((uint64_t)1 << (index % 64));
+  }
+
+  /*
+   * Leave a tombstone so the items after it stay reachable, unless probing
+   * is linear and the next entry is empty. In that case no probe goes past
+   * this entry and it can become empty too, along with the tombstones right
+   * before it.
+   */
+  next_entry = ht_entry_get(hash_table, (index + 1) % hash_table->size);
+  if (hash_table->probe == HT_PROBE_LINEAR &&
+      !ht_entry_used(hash_table, next_entry) &&
+      !ht_entry_deleted(hash_table, next_entry)) {
+    index = index ? index - 1 : hash_table->size - 1;
+    hash_entry = ht_entry_get(hash_table, index);
+
+    while (ht_entry_deleted(hash_table, hash_entry))
+    {
+      hash_entry->deleted = 0;
+      hash_table->tombstones--;
+      index = index ? index - 1 : hash_table->size - 1;
+      hash_entry = ht_entry_get(hash_table, index);
+    }
+  } else {
+    hash_entry->deleted = 1;
+    hash_table->tombstones++;
+  }
+  ht_write_end(hash_table);
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to get an item from the hash_table
+ *
+ * @param hash_table Hash pointer
+ * @param key Key
+ * @param[out] data Data of the item, may be NULL
+ * @return uint8_t 1 if the item was found else 0
+ */
+static inline uint8_t hash_get(ht_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint32_t now;
+  uint32_t hash;
+  uint32_t index;
+  uint32_t step;
+  ht_entry_t *hash_entry;
+  uint8_t *hash_entry_data;
+
+  hash = ht_hash(hash_table, key);
+  if (hash_table->sketch) {
+    ht_sketch_increment(hash_table->sketch, hash);
+  }
+
+  /* Most missing keys are not in the Bloom filter */
+  if (hash_table->bloom && !ht_bloom_contains(hash_table->bloom, hash)) {
+    return (0);
+  }
 
-    hash_table->count--;
-    hash_entry->used = 0;
+  now = hash_now(hash_table);
+  hash_entry = hash_find(hash_table, key, hash, now,
+      hash_table->max_probe + 1, &index, &step);
+
+  /* If entry is found and it is used */
+  if (hash_entry && ht_entry_used(hash_table, hash_entry) &&
+      !hash_expired(hash_table, index, now)) {
+    /* Copy data */
     if (data) {
-      /* Copy data */
+      hash_entry_data =
+          (uint8_t *)(hash_entry + sizeof(ht_entry_t) +
+          hash_table->key_size);
+
       memcpy(data, hash_entry_data, hash_table->data_size);
     }
-    memset(hash_entry_key, 0, hash_table->key_size);
-    memset(hash_entry_data, 0, hash_table->data_size);
 
+    /* Give the item a second chance, without dirtying it every time */
+    if (hash_table->capacity && !hash_entry->referenced) {
+      hash_entry->referenced = 1;
+    }
     return (1);
   } else {
     return (0);
@@ -149,21 +1034,124 @@ uint8_t ht_remove(ht_t *hash_table, uint8_t *key, uint8_t *data)
 
 uint8_t ht_get(ht_t *hash_table, uint8_t *key, uint8_t *data)
 {
+  uint8_t found;
+
+  HT_COUNTERS_START(start);
+  found = hash_get(hash_table, key, data);
+  HT_COUNTERS_STOP(HT_COUNTERS_GET, start, found);
+
+  return (found);
+}
+
+
+uint8_t ht_peek(ht_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint32_t now;
+  uint32_t hash;
+  uint32_t index;
+  uint32_t step;
   ht_entry_t *hash_entry;
   uint8_t *hash_entry_data;
 
-  hash_entry = hash_find(hash_table, key);
+  hash = ht_hash(hash_table, key);
+  if (hash_table->bloom && !ht_bloom_contains(hash_table->bloom, hash)) {
+    return (0);
+  }
 
-  /* If entry is found and it is used */
-  if (hash_entry && hash_entry->used) {
-    /* Copy data */
-    hash_entry_data =
-        (uint8_t *)(hash_entry + sizeof(ht_entry_t) +
-        hash_table->key_size);
+  now = hash_now(hash_table);
+  hash_entry = hash_find(hash_table, key, hash, now,
+      hash_table->max_probe + 1, &index, &step);
 
-    memcpy(data, hash_entry_data, hash_table->data_size);
+  if (hash_entry && ht_entry_used(hash_table, hash_entry) &&
+      !hash_expired(hash_table, index, now)) {
+    if (data) {
+      hash_entry_data =
+          (uint8_t *)(hash_entry + sizeof(ht_entry_t) +
+          hash_table->key_size);
+
+      memcpy(data, hash_entry_data, hash_table->data_size);
+    }
     return (1);
   } else {
     return (0);
   }
 }
+
+
+uint8_t ht_get_optimistic(ht_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint8_t found = 0;
+  uint32_t now;
+  uint32_t index;
+  uint32_t step;
+  uint32_t hash;
+  uint32_t sequence;
+  ht_entry_t *hash_entry;
+  uint8_t *hash_entry_data;
+
+  now = hash_now(hash_table);
+
+  do {
+    /* Wait for the writer to leave the table in a consistent state */
+    sequence = __atomic_load_n(&hash_table->sequence, __ATOMIC_ACQUIRE);
+    if (sequence & 1) {
+      continue;
+    }
+
+    /* A reseed changes the hash, use the seed of this snapshot */
+    hash = ht_hash(hash_table, key);
+    found = 0;
+    hash_entry = hash_find(hash_table, key, hash, now,
+        hash_table->max_probe + 1, &index, &step);
+
+    /* Copy data, it is only trusted if the sequence did not change */
+    if (hash_entry && ht_entry_used(hash_table, hash_entry) &&
+        !hash_expired(hash_table, index, now)) {
+      hash_entry_data =
+          (uint8_t *)(hash_entry + sizeof(ht_entry_t) +
+          hash_table->key_size);
+
+      memcpy(data, hash_entry_data, hash_table->data_size);
+      found = 1;
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((sequence & 1) ||
+      __atomic_load_n(&hash_table->sequence, __ATOMIC_RELAXED) != sequence);
+
+  return (found);
+}
+
+
+uint8_t ht_foreach(ht_t *hash_table, ht_foreach_callback_t callback,
+    void *context)
+{
+  uint32_t i;
+  uint8_t action;
+  ht_entry_t *hash_entry;
+  uint8_t *hash_entry_key;
+
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_entry_get(hash_table, i);
+    if (!ht_entry_used(hash_table, hash_entry)) {
+      continue;
+    }
+
+    hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+
+    /* The callback may write to the data, keep optimistic readers out */
+    ht_write_begin(hash_table);
+    action = callback(hash_entry_key, hash_entry_key + hash_table->key_size,
+        context);
+    ht_write_end(hash_table);
+
+    if (action == HT_FOREACH_DELETE) {
+      ht_remove_entry(hash_table, i, NULL);
+    } else if (action == HT_FOREACH_STOP) {
+      return (0);
+    }
+  }
+
+  return (1);
+}
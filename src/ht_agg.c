@@ -0,0 +1,367 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_agg.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "ht_agg.h"
+
+/**
+ * @brief Parallel job struct, threads take partitions until none is left
+ *
+ */
+typedef struct ht_agg_job ht_agg_job_t;
+
+struct ht_agg_job {
+  /**
+   * @brief Aggregation pointer
+   *
+   */
+  ht_agg_t *    agg;
+
+  /**
+   * @brief Output tables, one per partition
+   *
+   */
+  ht_t *        outputs;
+
+  /**
+   * @brief Records array, used by ht_agg_collect
+   *
+   */
+  uint8_t *     records;
+
+  /**
+   * @brief Next partition to process
+   *
+   */
+  uint32_t      next;
+
+  /**
+   * @brief Set when a partition could not be processed
+   *
+   */
+  uint8_t       failed;
+
+  /**
+   * @brief Function processing one partition
+   *
+   */
+  uint8_t       (*run)(ht_agg_job_t *job, uint32_t partition);
+};
+
+/**
+ * @brief Merge context struct, passed to the ht_foreach callback
+ *
+ */
+typedef struct {
+  /**
+   * @brief Output table of the partition
+   *
+   */
+  ht_t *                        output;
+
+  /**
+   * @brief Combine callback
+   *
+   */
+  ht_combine_function_t         combine_function;
+} ht_agg_merge_t;
+
+/**
+ * @brief Collect context struct, passed to the ht_foreach callback
+ *
+ */
+typedef struct {
+  /**
+   * @brief Output table of the partition
+   *
+   */
+  ht_t *        output;
+
+  /**
+   * @brief Next record to write
+   *
+   */
+  uint8_t *     record;
+} ht_agg_collect_t;
+
+
+/**
+ * @brief Function to combine one item of a local table into the output
+ *
+ * @param key Item key
+ * @param data Item data
+ * @param context Merge context
+ * @return uint8_t HT_FOREACH_KEEP or HT_FOREACH_STOP if the output is full
+ */
+static uint8_t ht_agg_merge_item(uint8_t *key, uint8_t *data, void *context)
+{
+  ht_agg_merge_t *merge;
+
+  merge = (ht_agg_merge_t *)context;
+
+  if (!ht_accumulate(merge->output, key, data, merge->combine_function)) {
+    return (HT_FOREACH_STOP);
+  }
+
+  return (HT_FOREACH_KEEP);
+}
+
+
+/**
+ * @brief Function to copy one item of an output table to the records
+ *
+ * @param key Item key
+ * @param data Item data
+ * @param context Collect context
+ * @return uint8_t Always HT_FOREACH_KEEP
+ */
+static uint8_t ht_agg_collect_item(uint8_t *key, uint8_t *data,
+    void *context)
+{
+  ht_agg_collect_t *collect;
+  ht_t *output;
+
+  collect = (ht_agg_collect_t *)context;
+  output = collect->output;
+
+  memcpy(collect->record, key, output->key_size);
+  memcpy(collect->record + output->key_size, data, output->data_size);
+  collect->record += HT_AGG_RECORD_SIZE(output->key_size, output->data_size);
+
+  return (HT_FOREACH_KEEP);
+}
+
+
+/**
+ * @brief Function to merge the local tables of one partition
+ *
+ * @param job Job pointer
+ * @param partition Partition index
+ * @return uint8_t 1 if the partition was merged else 0
+ */
+static uint8_t ht_agg_merge_partition(ht_agg_job_t *job, uint32_t partition)
+{
+  uint32_t i;
+  ht_agg_t *agg;
+  ht_agg_merge_t merge;
+
+  agg = job->agg;
+  merge.output = &job->outputs[partition];
+  merge.combine_function = agg->combine_function;
+
+  for (i = 0; i < agg->workers; i++)
+  {
+    if (!ht_foreach(&agg->tables[i * agg->partitions + partition],
+        ht_agg_merge_item, &merge)) {
+      return (0);
+    }
+  }
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to copy one merged partition to its slice of the records
+ *
+ * @param job Job pointer
+ * @param partition Partition index
+ * @return uint8_t Always 1
+ */
+static uint8_t ht_agg_collect_partition(ht_agg_job_t *job,
+    uint32_t partition)
+{
+  uint32_t i;
+  uint32_t offset = 0;
+  ht_agg_collect_t collect;
+  ht_t *output;
+
+  output = &job->outputs[partition];
+
+  /* The slice starts after the items of the previous partitions */
+  for (i = 0; i < partition; i++)
+  {
+    offset += ht_count(&job->outputs[i]);
+  }
+
+  collect.output = output;
+  collect.record = job->records + (size_t)offset *
+      HT_AGG_RECORD_SIZE(output->key_size, output->data_size);
+
+  ht_foreach(output, ht_agg_collect_item, &collect);
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to process partitions until none is left
+ *
+ * @param arg Job pointer
+ * @return void* Always NULL
+ */
+static void *ht_agg_worker(void *arg)
+{
+  uint32_t partition;
+  ht_agg_job_t *job;
+
+  job = (ht_agg_job_t *)arg;
+
+  while ((partition = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+      job->agg->partitions)
+  {
+    if (!job->run(job, partition)) {
+      __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  return (NULL);
+}
+
+
+/**
+ * @brief Function to run a job on the calling thread and threads - 1 more
+ *
+ * Partitions are taken from a shared counter, so a thread that fails to
+ * start only leaves more work for the others.
+ *
+ * @param job Job pointer
+ * @param threads Number of threads
+ * @return uint8_t 1 if every partition was processed else 0
+ */
+static uint8_t ht_agg_run(ht_agg_job_t *job, uint32_t threads)
+{
+  uint32_t i;
+  uint8_t started[HT_AGG_MAX_THREADS];
+  pthread_t thread_ids[HT_AGG_MAX_THREADS];
+
+  if (!threads || threads > HT_AGG_MAX_THREADS) {
+    return (0);
+  }
+
+  job->next = 0;
+  job->failed = 0;
+
+  for (i = 1; i < threads; i++)
+  {
+    started[i] = !pthread_create(&thread_ids[i], NULL, ht_agg_worker, job);
+  }
+
+  ht_agg_worker(job);
+
+  for (i = 1; i < threads; i++)
+  {
+    if (started[i]) {
+      pthread_join(thread_ids[i], NULL);
+    }
+  }
+
+  return (!job->failed);
+}
+
+
+uint8_t ht_agg_init(ht_agg_t *agg, ht_t *tables, uint32_t workers,
+    uint32_t partitions, ht_combine_function_t combine_function)
+{
+  if (!workers || !partitions) {
+    return (0);
+  }
+
+  agg->tables = tables;
+  agg->workers = workers;
+  agg->partitions = partitions;
+  agg->combine_function = combine_function;
+
+  return (1);
+}
+
+
+uint32_t ht_agg_partition(ht_agg_t *agg, uint8_t *key)
+{
+  uint32_t hash;
+
+  hash = agg->tables[0].hash_function(key);
+
+  /* Use the high bits, the tables keep using the low bits */
+  return ((uint32_t)(((uint64_t)hash * agg->partitions) >> 32));
+}
+
+
+uint8_t ht_agg_update(ht_agg_t *agg, uint32_t worker, uint8_t *key,
+    uint8_t *delta)
+{
+  if (worker >= agg->workers) {
+    return (0);
+  }
+
+  return (ht_accumulate(&agg->tables[worker * agg->partitions +
+         ht_agg_partition(agg, key)], key, delta, agg->combine_function));
+}
+
+
+uint8_t ht_agg_merge(ht_agg_t *agg, ht_t *outputs, uint32_t threads)
+{
+  ht_agg_job_t job;
+
+  job.agg = agg;
+  job.outputs = outputs;
+  job.records = NULL;
+  job.run = ht_agg_merge_partition;
+
+  return (ht_agg_run(&job, threads));
+}
+
+
+uint32_t ht_agg_collect(ht_agg_t *agg, ht_t *outputs, uint32_t threads,
+    uint8_t *records)
+{
+  uint32_t i;
+  uint32_t count = 0;
+  ht_agg_job_t job;
+
+  job.agg = agg;
+  job.outputs = outputs;
+  job.records = records;
+  job.run = ht_agg_collect_partition;
+
+  if (!ht_agg_run(&job, threads)) {
+    return (0);
+  }
+
+  for (i = 0; i < agg->partitions; i++)
+  {
+    count += ht_count(&outputs[i]);
+  }
+
+  return (count);
+}
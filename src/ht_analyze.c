@@ -0,0 +1,289 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_analyze.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_analyze.h"
+
+
+/**
+ * @brief Function to saturate a value to 32 bits
+ *
+ * @param value Value
+ * @return uint32_t Value or UINT32_MAX if it does not fit
+ */
+static inline uint32_t ht_analyze_saturate(uint64_t value)
+{
+  return (value > UINT32_MAX ? UINT32_MAX : (uint32_t)value);
+}
+
+
+/**
+ * @brief Function to get the cluster histogram bucket of a length
+ *
+ * @param length Cluster length, not 0
+ * @return uint32_t Bucket
+ */
+static inline uint32_t ht_analyze_bucket(uint32_t length)
+{
+  uint32_t bucket;
+
+  bucket = 31 - (uint32_t)__builtin_clz(length);
+
+  return (bucket < HT_ANALYZE_CLUSTER_BUCKETS ? bucket :
+         HT_ANALYZE_CLUSTER_BUCKETS - 1);
+}
+
+
+/**
+ * @brief Function to compute the chi-square of the keys per entry
+ *
+ * @param hash_function Function to get hash from key
+ * @param keys Keys
+ * @param work Work buffer of size counters
+ * @param analyze Analysis, count, key_size and size are set
+ * @param key_size Size of the key in bytes
+ */
+static void ht_analyze_chi_square(hash_function_t hash_function,
+    uint8_t *keys, uint32_t *work, ht_analyze_t *analyze, uint32_t key_size)
+{
+  uint32_t i;
+  uint64_t sum;
+  uint64_t scaled;
+
+  memset(work, 0, (size_t)analyze->size * sizeof(uint32_t));
+  for (i = 0; i < analyze->count; i++)
+  {
+    work[hash_function(keys + (size_t)i * key_size) % analyze->size]++;
+  }
+
+  sum = 0;
+  for (i = 0; i < analyze->size; i++)
+  {
+    sum += (uint64_t)work[i] * work[i];
+  }
+
+  /* Sum of (c - e)^2 / e with e = count / size is sum * size / count - count */
+  if (__builtin_mul_overflow(sum, analyze->size, &scaled)) {
+    analyze->chi_square = UINT64_MAX;
+    return;
+  }
+
+  analyze->chi_square = (scaled / analyze->count) * 1000 +
+      ((scaled % analyze->count) * 1000) / analyze->count -
+      (uint64_t)analyze->count * 1000;
+}
+
+
+/**
+ * @brief Function to measure how the hash bits change with each key bit
+ *
+ * @param hash_function Function to get hash from key
+ * @param keys Keys
+ * @param analyze Analysis, count is set
+ * @param key_size Size of the key in bytes
+ */
+static void ht_analyze_avalanche(hash_function_t hash_function,
+    uint8_t *keys, ht_analyze_t *analyze, uint32_t key_size)
+{
+  uint32_t i;
+  uint32_t bit;
+  uint32_t out;
+  uint32_t bits;
+  uint32_t hash;
+  uint32_t flipped;
+  uint32_t chance;
+  uint32_t bias;
+  uint64_t total;
+  uint8_t *key;
+  uint32_t flips[HT_ANALYZE_AVALANCHE_BITS][32];
+
+  bits = key_size * 8 < HT_ANALYZE_AVALANCHE_BITS ? key_size * 8 :
+      HT_ANALYZE_AVALANCHE_BITS;
+  if (!bits) {
+    return;
+  }
+
+  memset(flips, 0, sizeof(flips));
+  for (i = 0; i < analyze->count; i++)
+  {
+    key = keys + (size_t)i * key_size;
+    hash = hash_function(key);
+
+    for (bit = 0; bit < bits; bit++)
+    {
+      key[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+      flipped = hash ^ hash_function(key);
+      key[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+
+      for ( ; flipped; flipped &= flipped - 1)
+      {
+        flips[bit][__builtin_ctz(flipped)]++;
+      }
+    }
+  }
+
+  total = 0;
+  bias = 0;
+  for (bit = 0; bit < bits; bit++)
+  {
+    for (out = 0; out < 32; out++)
+    {
+      total += flips[bit][out];
+      chance = (uint32_t)(((uint64_t)flips[bit][out] * 1000) /
+          analyze->count);
+      chance = chance > 500 ? chance - 500 : 500 - chance;
+      if (chance > bias) {
+        bias = chance;
+      }
+    }
+  }
+
+  analyze->avalanche_mean =
+      (uint32_t)((total * 1000) / ((uint64_t)analyze->count * bits * 32));
+  analyze->avalanche_bias = bias;
+}
+
+
+/**
+ * @brief Function to insert the keys in a simulated linear probing table
+ *
+ * @param hash_function Function to get hash from key
+ * @param keys Keys
+ * @param work Work buffer of size counters
+ * @param analyze Analysis, count and size are set
+ * @param key_size Size of the key in bytes
+ */
+static void ht_analyze_probes(hash_function_t hash_function, uint8_t *keys,
+    uint32_t *work, ht_analyze_t *analyze, uint32_t key_size)
+{
+  uint32_t i;
+  uint32_t start;
+  uint32_t index;
+  uint32_t length;
+  uint32_t distance;
+  uint64_t ratio;
+  uint64_t hit_total;
+  uint64_t miss_total;
+
+  /* Same placement as hash_find with no removed entries */
+  memset(work, 0, (size_t)analyze->size * sizeof(uint32_t));
+  hit_total = 0;
+  for (i = 0; i < analyze->count; i++)
+  {
+    index = hash_function(keys + (size_t)i * key_size) % analyze->size;
+
+    for (distance = 0; work[index]; distance++)
+    {
+      index = (index + 1) % analyze->size;
+    }
+    work[index] = 1;
+
+    hit_total += distance + 1;
+    if (distance > analyze->max_probe) {
+      analyze->max_probe = distance;
+    }
+  }
+  analyze->probe_hit = (uint32_t)((hit_total * 1000) / analyze->count);
+
+  /* Walk the clusters from an empty entry so none wraps around */
+  start = 0;
+  while (start < analyze->size && work[start])
+  {
+    start++;
+  }
+
+  miss_total = 0;
+  if (start == analyze->size) {
+    /* A full table has one cluster and misses never end */
+    analyze->clusters = 1;
+    analyze->largest_cluster = analyze->size;
+    analyze->cluster_histogram[ht_analyze_bucket(analyze->size)]++;
+    analyze->probe_miss = UINT32_MAX;
+  } else {
+    length = 0;
+    for (i = 1; i <= analyze->size; i++)
+    {
+      index = (start + i) % analyze->size;
+
+      if (work[index]) {
+        length++;
+        continue;
+      }
+
+      /* A miss starting in the cluster probes the rest of it and an empty */
+      miss_total += 1 + (uint64_t)length * (length + 3) / 2;
+      if (length) {
+        analyze->clusters++;
+        if (length > analyze->largest_cluster) {
+          analyze->largest_cluster = length;
+        }
+        analyze->cluster_histogram[ht_analyze_bucket(length)]++;
+      }
+      length = 0;
+    }
+
+    analyze->probe_miss =
+        ht_analyze_saturate((miss_total * 1000) / analyze->size);
+  }
+
+  /* Knuth: (1 + 1 / (1 - a)) / 2 for hits, (1 + 1 / (1 - a)^2) / 2 for misses */
+  if (analyze->count == analyze->size) {
+    analyze->probe_hit_expected = UINT32_MAX;
+    analyze->probe_miss_expected = UINT32_MAX;
+  } else {
+    ratio = ((uint64_t)analyze->size * 1000) /
+        (analyze->size - analyze->count);
+    analyze->probe_hit_expected = ht_analyze_saturate(500 + ratio / 2);
+    analyze->probe_miss_expected =
+        ht_analyze_saturate(500 + (ratio * ratio) / 2000);
+  }
+}
+
+
+uint8_t ht_analyze(hash_function_t hash_function, uint8_t *keys,
+    uint32_t count, uint32_t key_size, uint32_t size, uint32_t *work,
+    ht_analyze_t *analyze)
+{
+  if (!count || count > size) {
+    return (0);
+  }
+
+  memset(analyze, 0, sizeof(*analyze));
+  analyze->size = size;
+  analyze->count = count;
+
+  ht_analyze_chi_square(hash_function, keys, work, analyze, key_size);
+  ht_analyze_avalanche(hash_function, keys, analyze, key_size);
+  ht_analyze_probes(hash_function, keys, work, analyze, key_size);
+
+  return (1);
+}
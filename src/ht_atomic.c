@@ -0,0 +1,532 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_atomic.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_atomic.h"
+
+
+/**
+ * @brief Function to get an entry by its index
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param index Entry index
+ * @return ht_atomic_entry_t* A pointer to the entry
+ */
+static inline ht_atomic_entry_t *ht_atomic_entry(ht_atomic_t *hash_table,
+    uint32_t index)
+{
+  return ((ht_atomic_entry_t *)(hash_table->data +
+         (uintptr_t)index * hash_table->entry_size));
+}
+
+
+/**
+ * @brief Function to get the key stored in an entry
+ *
+ * @param hash_entry Entry pointer
+ * @return uint8_t* A pointer to the entry key
+ */
+static inline uint8_t *ht_atomic_entry_key(ht_atomic_entry_t *hash_entry)
+{
+  return ((uint8_t *)(hash_entry + 1));
+}
+
+
+/**
+ * @brief Function to wait while another writer owns an entry
+ *
+ * @param hash_entry Entry pointer
+ * @return uint32_t The first state word that is not busy
+ */
+static uint32_t ht_atomic_wait(ht_atomic_entry_t *hash_entry)
+{
+  uint32_t state;
+
+  do {
+    state = __atomic_load_n(&hash_entry->state, __ATOMIC_ACQUIRE);
+  } while ((state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_BUSY);
+
+  return (state);
+}
+
+
+/**
+ * @brief Function to compare the key of an entry
+ *
+ * A deleted entry may be claimed for another key while its key is read,
+ * the comparison only holds if the generation did not change meanwhile.
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param hash_entry Entry pointer
+ * @param state State word read before the key
+ * @param key Key
+ * @param[out] equal 1 if the entry holds the key else 0
+ * @return uint8_t 1 if the key was read within one generation else 0
+ */
+static uint8_t ht_atomic_compare(ht_atomic_t *hash_table,
+    ht_atomic_entry_t *hash_entry, uint32_t state, uint8_t *key,
+    uint8_t *equal)
+{
+  *equal = !memcmp(ht_atomic_entry_key(hash_entry), key,
+      hash_table->key_size);
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  return (((__atomic_load_n(&hash_entry->state, __ATOMIC_RELAXED) ^ state) &
+         ~(uint32_t)HT_ATOMIC_STATE_MASK) == 0);
+}
+
+
+/**
+ * @brief Function to find the live entry holding a key
+ *
+ * Busy entries are skipped: either they hold a key that is not published
+ * yet or a key that is being inserted again, neither is visible.
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param key Key
+ * @param[out] state State word of the entry found
+ * @return ht_atomic_entry_t* A pointer to the entry found or NULL if not found
+ */
+static ht_atomic_entry_t *ht_atomic_find(ht_atomic_t *hash_table, uint8_t *key,
+    uint32_t *state)
+{
+  uint32_t i;
+  uint32_t index;
+  uint8_t equal;
+  ht_atomic_entry_t *hash_entry;
+
+  index = hash_table->hash_function(key) % hash_table->size;
+
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_atomic_entry(hash_table, index);
+    *state = __atomic_load_n(&hash_entry->state, __ATOMIC_ACQUIRE);
+
+    /* Published entries never become empty, the key is not further ahead */
+    if (*state == HT_ATOMIC_EMPTY) {
+      return (NULL);
+    }
+
+    if ((*state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_LIVE &&
+        ht_atomic_compare(hash_table, hash_entry, *state, key, &equal) &&
+        equal) {
+      return (hash_entry);
+    }
+
+    index++;
+    if (index == hash_table->size) {
+      index = 0;
+    }
+  }
+
+  return (NULL);
+}
+
+
+/**
+ * @brief Function to check that a claimed key is not in any other entry
+ *
+ * Two writers may claim different entries for the same key at once, when
+ * an entry is deleted behind one of them. Both look at the probe sequence
+ * again after claiming, so at least one of them sees the other and gives
+ * up; any busy entry is taken as a possible copy of the key.
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param claimed Entry claimed for the key, in busy state
+ * @param index First index of the probe sequence of the key
+ * @param key Key
+ * @return uint8_t 1 if no other entry may hold the key else 0
+ */
+static uint8_t ht_atomic_unique(ht_atomic_t *hash_table,
+    ht_atomic_entry_t *claimed, uint32_t index, uint8_t *key)
+{
+  uint32_t i;
+  uint32_t state;
+  uint8_t equal;
+  ht_atomic_entry_t *hash_entry;
+
+  for (i = 0; i < hash_table->size; i++)
+  {
+    hash_entry = ht_atomic_entry(hash_table, index);
+    if (hash_entry != claimed) {
+      state = __atomic_load_n(&hash_entry->state, __ATOMIC_SEQ_CST);
+      if (state == HT_ATOMIC_EMPTY) {
+        return (1);
+      }
+
+      if ((state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_BUSY) {
+        return (0);
+      }
+
+      if ((state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_LIVE &&
+          (!ht_atomic_compare(hash_table, hash_entry, state, key, &equal) ||
+          equal)) {
+        return (0);
+      }
+    }
+
+    index++;
+    if (index == hash_table->size) {
+      index = 0;
+    }
+  }
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to pin a live entry before changing its value in place
+ *
+ * @param hash_entry Entry pointer
+ * @param state State word the entry must still have
+ * @return uint8_t 1 if the entry was pinned else 0
+ */
+static uint8_t ht_atomic_pin(ht_atomic_entry_t *hash_entry, uint32_t state)
+{
+  /* Either the pin is seen by a writer claiming the entry, or its claim */
+  __atomic_fetch_add(&hash_entry->pins, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&hash_entry->state, __ATOMIC_SEQ_CST) == state) {
+    return (1);
+  }
+
+  __atomic_fetch_sub(&hash_entry->pins, 1, __ATOMIC_RELEASE);
+
+  return (0);
+}
+
+
+/**
+ * @brief Function to unpin an entry
+ *
+ * @param hash_entry Entry pointer
+ */
+static void ht_atomic_unpin(ht_atomic_entry_t *hash_entry)
+{
+  __atomic_fetch_sub(&hash_entry->pins, 1, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief Function to publish the data of a claimed entry
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param hash_entry Entry pointer in busy state
+ * @param data Item data
+ * @param state Busy state word of the entry
+ */
+static void ht_atomic_publish(ht_atomic_t *hash_table,
+    ht_atomic_entry_t *hash_entry, uint8_t *data, uint32_t state)
+{
+  uint64_t value = 0;
+
+  memcpy(&value, data, hash_table->data_size);
+  __atomic_store_n(&hash_entry->value, value, __ATOMIC_RELAXED);
+  __atomic_store_n(&hash_entry->state,
+      (state & ~(uint32_t)HT_ATOMIC_STATE_MASK) | HT_ATOMIC_LIVE,
+      __ATOMIC_RELEASE);
+  __atomic_fetch_add(&hash_table->count, 1, __ATOMIC_RELAXED);
+}
+
+
+uint8_t ht_atomic_init(ht_atomic_t *hash_table, hash_function_t hash_function,
+    uint32_t size, uint32_t data_size, uint32_t key_size, uint8_t *data)
+{
+  if (!size || data_size > sizeof(uint64_t)) {
+    return (0);
+  }
+
+  hash_table->hash_function = hash_function;
+  hash_table->data = data;
+  hash_table->size = size;
+  hash_table->count = 0;
+  hash_table->data_size = data_size;
+  hash_table->key_size = key_size;
+  hash_table->entry_size = HT_ATOMIC_ENTRY_SIZE(key_size);
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to insert an item unless its key is live
+ *
+ * @param hash_table Concurrent hash pointer
+ * @param key Item key
+ * @param data Item data
+ * @param[out] live_entry Live entry of the key, NULL if the table is full
+ * @param[out] live_state State word of the live entry
+ * @return uint8_t 1 if the item was inserted else 0
+ */
+static uint8_t ht_atomic_claim(ht_atomic_t *hash_table, uint8_t *key,
+    uint8_t *data, ht_atomic_entry_t **live_entry, uint32_t *live_state)
+{
+  uint32_t i;
+  uint32_t home;
+  uint32_t index;
+  uint32_t state;
+  uint32_t claimed;
+  uint32_t expected;
+  uint32_t reuse_state = 0;
+  uint8_t equal = 0;
+  ht_atomic_entry_t *hash_entry = NULL;
+  ht_atomic_entry_t *reuse_entry;
+
+  *live_entry = NULL;
+  home = hash_table->hash_function(key) % hash_table->size;
+
+  for ( ; ; )
+  {
+    /* Look for the key, remembering the first deleted entry on the way */
+    reuse_entry = NULL;
+    index = home;
+    state = HT_ATOMIC_EMPTY;
+    for (i = 0; i < hash_table->size; )
+    {
+      hash_entry = ht_atomic_entry(hash_table, index);
+      state = ht_atomic_wait(hash_entry);
+      if (state == HT_ATOMIC_EMPTY) {
+        break;
+      }
+
+      /* The entry was claimed for another key, look at it again */
+      if (!ht_atomic_compare(hash_table, hash_entry, state, key, &equal)) {
+        continue;
+      }
+
+      if (equal) {
+        break;
+      }
+
+      if (!reuse_entry &&
+          (state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_DELETED) {
+        reuse_entry = hash_entry;
+        reuse_state = state;
+      }
+
+      i++;
+      index++;
+      if (index == hash_table->size) {
+        index = 0;
+      }
+    }
+
+    if (state != HT_ATOMIC_EMPTY && equal) {
+      if ((state & HT_ATOMIC_STATE_MASK) == HT_ATOMIC_LIVE) {
+        *live_entry = hash_entry;
+        *live_state = state;
+        return (0);
+      }
+
+      /* Bring a deleted key back to life */
+      claimed = (state & ~(uint32_t)HT_ATOMIC_STATE_MASK) | HT_ATOMIC_BUSY;
+    } else if (reuse_entry) {
+      /* Store the key over the first deleted entry, in a new generation */
+      hash_entry = reuse_entry;
+      state = reuse_state;
+      claimed = ((state & ~(uint32_t)HT_ATOMIC_STATE_MASK) +
+          HT_ATOMIC_GENERATION) | HT_ATOMIC_BUSY;
+    } else if (state == HT_ATOMIC_EMPTY) {
+      claimed = HT_ATOMIC_BUSY;
+    } else {
+      return (0);
+    }
+
+    /* Lost the race, look at the probe sequence again */
+    expected = state;
+    if (!__atomic_compare_exchange_n(&hash_entry->state, &expected, claimed,
+        0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+      continue;
+    }
+
+    if (hash_entry == reuse_entry) {
+      /* A writer of the previous key may still be changing the value */
+      if (__atomic_load_n(&hash_entry->pins, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&hash_entry->state, state, __ATOMIC_RELEASE);
+        continue;
+      }
+
+      /* Readers of the previous key see the generation before the key */
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    if (hash_entry == reuse_entry || state == HT_ATOMIC_EMPTY) {
+      memcpy(ht_atomic_entry_key(hash_entry), key, hash_table->key_size);
+    }
+
+    if (!ht_atomic_unique(hash_table, hash_entry, home, key)) {
+      __atomic_store_n(&hash_entry->state, state == HT_ATOMIC_EMPTY ?
+          HT_ATOMIC_EMPTY : (claimed & ~(uint32_t)HT_ATOMIC_STATE_MASK) |
+          HT_ATOMIC_DELETED, __ATOMIC_RELEASE);
+      continue;
+    }
+
+    ht_atomic_publish(hash_table, hash_entry, data, claimed);
+
+    return (1);
+  }
+}
+
+
+uint8_t ht_atomic_insert(ht_atomic_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint32_t live_state;
+  ht_atomic_entry_t *live_entry;
+
+  return (ht_atomic_claim(hash_table, key, data, &live_entry, &live_state));
+}
+
+
+uint8_t ht_atomic_accumulate(ht_atomic_t *hash_table, uint8_t *key,
+    uint64_t delta, uint8_t operation)
+{
+  uint64_t value;
+  uint32_t live_state;
+  ht_atomic_entry_t *live_entry;
+
+  if (hash_table->data_size != sizeof(uint64_t)) {
+    return (0);
+  }
+
+  /* A live entry removed before it is pinned gets the key inserted again */
+  do {
+    if (ht_atomic_claim(hash_table, key, (uint8_t *)&delta, &live_entry,
+        &live_state)) {
+      return (1);
+    }
+
+    if (!live_entry) {
+      return (0);
+    }
+  } while (!ht_atomic_pin(live_entry, live_state));
+
+  if (operation == HT_ATOMIC_ADD) {
+    __atomic_fetch_add(&live_entry->value, delta, __ATOMIC_RELAXED);
+  } else {
+    /* Retry until the value is replaced or already wins the comparison */
+    value = __atomic_load_n(&live_entry->value, __ATOMIC_RELAXED);
+    while ((operation == HT_ATOMIC_MIN ? delta < value : delta > value) &&
+        !__atomic_compare_exchange_n(&live_entry->value, &value, delta, 1,
+        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+  }
+
+  ht_atomic_unpin(live_entry);
+
+  return (1);
+}
+
+
+uint8_t ht_atomic_remove(ht_atomic_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint64_t value;
+  uint32_t state;
+  uint32_t expected;
+  ht_atomic_entry_t *hash_entry;
+
+  hash_entry = ht_atomic_find(hash_table, key, &state);
+  if (!hash_entry) {
+    return (0);
+  }
+
+  do {
+    expected = __atomic_load_n(&hash_entry->state, __ATOMIC_ACQUIRE);
+    if (expected != state) {
+      return (0);
+    }
+
+    value = __atomic_load_n(&hash_entry->value, __ATOMIC_RELAXED);
+  } while (!__atomic_compare_exchange_n(&hash_entry->state, &expected,
+      (state & ~(uint32_t)HT_ATOMIC_STATE_MASK) | HT_ATOMIC_DELETED, 0,
+      __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  __atomic_fetch_sub(&hash_table->count, 1, __ATOMIC_RELAXED);
+
+  if (data) {
+    memcpy(data, &value, hash_table->data_size);
+  }
+
+  return (1);
+}
+
+
+uint8_t ht_atomic_get(ht_atomic_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint64_t value;
+  uint32_t state;
+  ht_atomic_entry_t *hash_entry;
+
+  hash_entry = ht_atomic_find(hash_table, key, &state);
+  if (!hash_entry) {
+    return (0);
+  }
+
+  /* The value belongs to the key only if the state did not change */
+  value = __atomic_load_n(&hash_entry->value, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&hash_entry->state, __ATOMIC_RELAXED) != state) {
+    return (0);
+  }
+
+  memcpy(data, &value, hash_table->data_size);
+
+  return (1);
+}
+
+
+uint8_t ht_atomic_update(ht_atomic_t *hash_table, uint8_t *key, uint8_t *data)
+{
+  uint64_t value = 0;
+  uint32_t state;
+  ht_atomic_entry_t *hash_entry;
+
+  hash_entry = ht_atomic_find(hash_table, key, &state);
+
+  /* The pin keeps the entry for the key, a remove may still race with it */
+  if (!hash_entry || !ht_atomic_pin(hash_entry, state)) {
+    return (0);
+  }
+
+  memcpy(&value, data, hash_table->data_size);
+  __atomic_store_n(&hash_entry->value, value, __ATOMIC_RELAXED);
+  ht_atomic_unpin(hash_entry);
+
+  return (1);
+}
+
+
+uint32_t ht_atomic_count(ht_atomic_t *hash_table)
+{
+  return (__atomic_load_n(&hash_table->count, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_bloom.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_bloom.h"
+
+
+/**
+ * @brief Function to get the block of a hash and the bits to test in it
+ *
+ * @param bloom Bloom filter pointer
+ * @param hash Hash of the key
+ * @param[out] bits Low half of the mixed hash, the bit positions come from it
+ * @return uint64_t* A pointer to the block
+ */
+static inline uint64_t *ht_bloom_block(ht_bloom_t *bloom, uint32_t hash,
+    uint32_t *bits)
+{
+  uint64_t mixed;
+
+  /* Murmur3 finalizer, the block uses the high half and the bits the low */
+  mixed = hash;
+  mixed ^= mixed >> 33;
+  mixed *= 0xff51afd7ed558ccdull;
+  mixed ^= mixed >> 33;
+  mixed *= 0xc4ceb9fe1a85ec53ull;
+  mixed ^= mixed >> 33;
+
+  *bits = (uint32_t)mixed;
+
+  return (&bloom->blocks[((mixed >> 32) * bloom->block_count >> 32) *
+         HT_BLOOM_BLOCK_WORDS]);
+}
+
+
+uint8_t ht_bloom_init(ht_bloom_t *bloom, uint32_t block_count,
+    uint64_t *blocks)
+{
+  if (!block_count) {
+    return (0);
+  }
+
+  bloom->blocks = blocks;
+  bloom->block_count = block_count;
+
+  ht_bloom_clear(bloom);
+
+  return (1);
+}
+
+
+void ht_bloom_add(ht_bloom_t *bloom, uint32_t hash)
+{
+  uint32_t i;
+  uint32_t bit;
+  uint32_t bits;
+  uint64_t *block;
+
+  block = ht_bloom_block(bloom, hash, &bits);
+
+  for (i = 0; i < HT_BLOOM_HASHES; i++)
+  {
+    bit = ((bits & 0xffff) + i * ((bits >> 16) | 1)) & 511;
+    block[bit / 64] |= (uint64_t)1 << (bit % 64);
+  }
+}
+
+
+uint8_t ht_bloom_contains(ht_bloom_t *bloom, uint32_t hash)
+{
+  uint32_t i;
+  uint32_t bit;
+  uint32_t bits;
+  uint64_t *block;
+
+  block = ht_bloom_block(bloom, hash, &bits);
+
+  for (i = 0; i < HT_BLOOM_HASHES; i++)
+  {
+    bit = ((bits & 0xffff) + i * ((bits >> 16) | 1)) & 511;
+    if (!(block[bit / 64] & ((uint64_t)1 << (bit % 64)))) {
+      return (0);
+    }
+  }
+
+  return (1);
+}
+
+
+void ht_bloom_clear(ht_bloom_t *bloom)
+{
+  memset(bloom->blocks, 0,
+      (size_t)HT_BLOOM_WORDS(bloom->block_count) * sizeof(uint64_t));
+}
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_counters.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_counters.h"
+
+#ifdef HT_STATS
+_Thread_local ht_counters_t ht_counters_local;
+#endif /* HT_STATS */
+
+
+uint8_t ht_counters_get(ht_counters_t *counters)
+{
+#ifdef HT_STATS
+  memcpy(counters, &ht_counters_local, sizeof(*counters));
+
+  return (1);
+#else
+  memset(counters, 0, sizeof(*counters));
+
+  return (0);
+#endif /* HT_STATS */
+}
+
+
+uint8_t ht_counters_reset(void)
+{
+#ifdef HT_STATS
+  memset(&ht_counters_local, 0, sizeof(ht_counters_local));
+
+  return (1);
+#else
+  return (0);
+#endif /* HT_STATS */
+}
+
+
+uint8_t ht_counters_merge(ht_counters_t *total, ht_counters_t *counters)
+{
+  uint32_t i;
+  uint32_t j;
+
+  for (i = 0; i < HT_COUNTERS_OPERATIONS; i++)
+  {
+    total->calls[i] += counters->calls[i];
+    total->hits[i] += counters->hits[i];
+
+    for (j = 0; j < HT_COUNTERS_LATENCY_BUCKETS; j++)
+    {
+      total->latency[i][j] += counters->latency[i][j];
+    }
+  }
+
+  total->finds += counters->finds;
+  total->probes += counters->probes;
+  total->compares += counters->compares;
+
+  return (1);
+}
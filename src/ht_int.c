@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_int.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <stddef.h>
+
+#include "ht_int.h"
+
+/**
+ * @brief Macro defining the functions of an integer hash
+ *
+ * The 64 bits and 32 bits integer hashes only differ in their key and value
+ * type and hash function, both are generated from this one body. A find
+ * returns the entry of a key, not HT_INT_EMPTY_KEY, or the empty entry that
+ * ends its cluster, or NULL if the hash is full. A remove shifts back the
+ * items after the hole that would no longer be reachable from their home
+ * entry, until an empty entry ends the cluster.
+ *
+ * @param prefix Prefix of the hash types and functions
+ * @param int_t Key and value type
+ * @param hash Hash function of the keys
+ */
+#define HT_INT_DEFINE(prefix, int_t, hash) \
+  static prefix##_entry_t *prefix##_find(prefix##_t *hash_table, int_t key) \
+  { \
+    uint32_t i; \
+    uint32_t index; \
+    prefix##_entry_t *hash_entry; \
+ \
+    index = (uint32_t)hash(key) & hash_table->mask; \
+ \
+    for (i = 0; i <= hash_table->mask; i++) \
+    { \
+      hash_entry = &hash_table->entries[index]; \
+      if (hash_entry->key == key || hash_entry->key == HT_INT_EMPTY_KEY) { \
+        return (hash_entry); \
+      } \
+ \
+      index = (index + 1) & hash_table->mask; \
+    } \
+ \
+    return (NULL); \
+  } \
+ \
+ \
+  uint8_t prefix##_init(prefix##_t *hash_table, uint32_t size, \
+      prefix##_entry_t *entries) \
+  { \
+    uint32_t i; \
+ \
+    if (!size || (size & (size - 1))) { \
+      return (0); \
+    } \
+ \
+    hash_table->entries = entries; \
+    hash_table->mask = size - 1; \
+    hash_table->count = 0; \
+    hash_table->empty_key_used = 0; \
+    hash_table->empty_key_value = 0; \
+ \
+    for (i = 0; i < size; i++) \
+    { \
+      entries[i].key = HT_INT_EMPTY_KEY; \
+    } \
+ \
+    return (1); \
+  } \
+ \
+ \
+  uint8_t prefix##_insert(prefix##_t *hash_table, int_t key, int_t value) \
+  { \
+    prefix##_entry_t *hash_entry; \
+ \
+    if (key == HT_INT_EMPTY_KEY) { \
+      if (hash_table->empty_key_used) { \
+        return (0); \
+      } \
+ \
+      hash_table->empty_key_used = 1; \
+      hash_table->empty_key_value = value; \
+      hash_table->count++; \
+      return (1); \
+    } \
+ \
+    hash_entry = prefix##_find(hash_table, key); \
+    if (!hash_entry || hash_entry->key == key) { \
+      return (0); \
+    } \
+ \
+    hash_entry->key = key; \
+    hash_entry->value = value; \
+    hash_table->count++; \
+ \
+    return (1); \
+  } \
+ \
+ \
+  uint8_t prefix##_remove(prefix##_t *hash_table, int_t key, int_t *value) \
+  { \
+    uint32_t hole; \
+    uint32_t index; \
+    uint32_t home; \
+    prefix##_entry_t *hash_entry; \
+ \
+    if (key == HT_INT_EMPTY_KEY) { \
+      if (!hash_table->empty_key_used) { \
+        return (0); \
+      } \
+ \
+      if (value) { \
+        *value = hash_table->empty_key_value; \
+      } \
+      hash_table->empty_key_used = 0; \
+      hash_table->count--; \
+      return (1); \
+    } \
+ \
+    hash_entry = prefix##_find(hash_table, key); \
+    if (!hash_entry || hash_entry->key != key) { \
+      return (0); \
+    } \
+ \
+    if (value) { \
+      *value = hash_entry->value; \
+    } \
+    hash_table->count--; \
+ \
+    hash_entry->key = HT_INT_EMPTY_KEY; \
+    hole = (uint32_t)(hash_entry - hash_table->entries); \
+    index = hole; \
+    for ( ; ; ) \
+    { \
+      index = (index + 1) & hash_table->mask; \
+      hash_entry = &hash_table->entries[index]; \
+      if (hash_entry->key == HT_INT_EMPTY_KEY) { \
+        break; \
+      } \
+ \
+      /* Keep items whose home is cyclically after the hole */ \
+      home = (uint32_t)hash(hash_entry->key) & hash_table->mask; \
+      if (((index - home) & hash_table->mask) < \
+          ((index - hole) & hash_table->mask)) { \
+        continue; \
+      } \
+ \
+      hash_table->entries[hole] = *hash_entry; \
+      hash_entry->key = HT_INT_EMPTY_KEY; \
+      hole = index; \
+    } \
+ \
+    return (1); \
+  } \
+ \
+ \
+  uint8_t prefix##_get(prefix##_t *hash_table, int_t key, int_t *value) \
+  { \
+    prefix##_entry_t *hash_entry; \
+ \
+    if (key == HT_INT_EMPTY_KEY) { \
+      if (hash_table->empty_key_used && value) { \
+        *value = hash_table->empty_key_value; \
+      } \
+      return (hash_table->empty_key_used); \
+    } \
+ \
+    hash_entry = prefix##_find(hash_table, key); \
+    if (!hash_entry || hash_entry->key != key) { \
+      return (0); \
+    } \
+ \
+    if (value) { \
+      *value = hash_entry->value; \
+    } \
+ \
+    return (1); \
+  } \
+ \
+ \
+  uint32_t prefix##_count(prefix##_t *hash_table) \
+  { \
+    return (hash_table->count); \
+  }
+
+
+uint64_t ht_int_hash(uint64_t key)
+{
+  /* Murmur3 finalizer, every input bit affects every output bit */
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ull;
+  key ^= key >> 33;
+
+  return (key);
+}
+
+
+uint32_t ht_int32_hash(uint32_t key)
+{
+  /* Murmur3 32 bits finalizer */
+  key ^= key >> 16;
+  key *= 0x85ebca6bu;
+  key ^= key >> 13;
+  key *= 0xc2b2ae35u;
+  key ^= key >> 16;
+
+  return (key);
+}
+
+
+HT_INT_DEFINE(ht_int, uint64_t, ht_int_hash)
+
+
+HT_INT_DEFINE(ht_int32, uint32_t, ht_int32_hash)
@@ -30,12 +30,150 @@
  */
 
 #include <string.h>
+#include <pthread.h>
 
 #include "ht_iter.h"
 
+/**
+ * @brief Parallel iteration worker struct
+ *
+ */
+typedef struct {
+  /**
+   * @brief Iterator over the worker range
+   *
+   */
+  ht_iter_t             ht_iterator;
+
+  /**
+   * @brief Range index
+   *
+   */
+  uint32_t              part;
+
+  /**
+   * @brief Function called for each item
+   *
+   */
+  ht_iter_callback_t    callback;
+
+  /**
+   * @brief Context passed to the callback
+   *
+   */
+  void *                context;
+} ht_iter_worker_t;
+
+
+/**
+ * @brief Function to get the next used entry of an iterator
+ *
+ * @param ht_iterator Hash table iterator pointer
+ * @param hash_table Hash table pointer
+ * @return ht_entry_t* A pointer to the next used entry or NULL at the end
+ */
+static ht_entry_t *ht_iter_next_entry(ht_iter_t *ht_iterator,
+    ht_t *hash_table)
+{
+  uint32_t index;
+  uint64_t occupancy;
+  ht_entry_t *hash_entry;
+
+  /* Jump straight to the used entries when the bitmap is available */
+  if (hash_table->occupancy) {
+    while (ht_iterator->current < ht_iterator->end)
+    {
+      occupancy = hash_table->occupancy[ht_iterator->current / 64] &
+          (~(uint64_t)0 << (ht_iterator->current % 64));
+
+      if (occupancy) {
+        index = (ht_iterator->current & ~(uint32_t)63) +
+            (uint32_t)__builtin_ctzll(occupancy);
+        if (index >= ht_iterator->end) {
+          break;
+        }
+
+        /* Bits of entries emptied by ht_clear are reset one slice at a time */
+        ht_iterator->current = index + 1;
+        hash_entry = ht_entry_get(hash_table, index);
+        if (ht_entry_used(hash_table, hash_entry)) {
+          return (hash_entry);
+        }
+
+        continue;
+      }
+
+      ht_iterator->current = (ht_iterator->current | 63) + 1;
+    }
+
+    ht_iterator->current = ht_iterator->end;
+    return (NULL);
+  }
+
+  /* Iterate over the entries */
+  for ( ; ht_iterator->current < ht_iterator->end;
+      ht_iterator->current++)
+  {
+    hash_entry = ht_entry_get(hash_table, ht_iterator->current);
+
+    if (ht_entry_used(hash_table, hash_entry)) {
+      ht_iterator->current++;
+      return (hash_entry);
+    }
+  }
+
+  return (NULL);
+}
+
+
+/**
+ * @brief Function to visit every item in the range of a worker
+ *
+ * @param arg Worker pointer
+ * @return void* Always NULL
+ */
+static void *ht_iter_worker(void *arg)
+{
+  ht_iter_worker_t *worker;
+  ht_entry_t *hash_entry;
+  uint8_t *hash_entry_key;
+  ht_t *hash_table;
+
+  worker = (ht_iter_worker_t *)arg;
+  hash_table = worker->ht_iterator.hash_table;
+
+  while ((hash_entry = ht_iter_next_entry(&worker->ht_iterator, hash_table)))
+  {
+    hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+    worker->callback(hash_entry_key, hash_entry_key + hash_table->key_size,
+        worker->part, worker->context);
+  }
+
+  return (NULL);
+}
+
+
 uint8_t ht_iter_init(ht_iter_t *ht_iterator, ht_t *hash_table)
 {
   ht_iterator->current = 0;
+  ht_iterator->end = hash_table->size;
+  ht_iterator->hash_table = hash_table;
+
+  return (1);
+}
+
+
+uint8_t ht_iter_init_range(ht_iter_t *ht_iterator, ht_t *hash_table,
+    uint32_t part, uint32_t parts)
+{
+  if (part >= parts) {
+    return (0);
+  }
+
+  ht_iterator->current =
+      (uint32_t)(((uint64_t)hash_table->size * part) / parts);
+  ht_iterator->end =
+      (uint32_t)(((uint64_t)hash_table->size * (part + 1)) / parts);
   ht_iterator->hash_table = hash_table;
 
   return (1);
@@ -45,30 +183,62 @@ uint8_t ht_iter_init(ht_iter_t *ht_iterator, ht_t *hash_table)
 uint8_t ht_iter_get_next(ht_iter_t *ht_iterator, ht_t *hash_table, uint8_t *key,
     uint8_t *data)
 {
-  uint32_t position;
   ht_entry_t *hash_entry;
   uint8_t *hash_entry_key;
   uint8_t *hash_entry_data;
 
-  /* Iterate over the entries */
-  for ( ; ht_iterator->current < hash_table->size;
-      ht_iterator->current++)
+  hash_entry = ht_iter_next_entry(ht_iterator, hash_table);
+
+  if (hash_entry) {
+    hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
+    hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+
+    memcpy(key, hash_entry_key, hash_table->key_size);
+    memcpy(data, hash_entry_data, hash_table->data_size);
+    return (1);
+  } else {
+    return (0);
+  }
+}
+
+
+uint8_t ht_parallel_foreach(ht_t *hash_table, uint32_t threads,
+    ht_iter_callback_t callback, void *context)
+{
+  uint32_t i;
+  uint8_t started[HT_ITER_MAX_THREADS];
+  pthread_t thread_ids[HT_ITER_MAX_THREADS];
+  ht_iter_worker_t workers[HT_ITER_MAX_THREADS];
+
+  if (!threads || threads > HT_ITER_MAX_THREADS) {
+    return (0);
+  }
+
+  for (i = 0; i < threads; i++)
   {
-    position = ht_iterator->current *
-        (sizeof(ht_entry_t) + hash_table->key_size +
-        hash_table->data_size);
-    hash_entry = (ht_entry_t *)(hash_table->data + position);
+    ht_iter_init_range(&workers[i].ht_iterator, hash_table, i, threads);
+    workers[i].part = i;
+    workers[i].callback = callback;
+    workers[i].context = context;
+  }
 
-    if (hash_entry->used) {
-      hash_entry_key = (uint8_t *)(hash_entry + sizeof(ht_entry_t));
-      hash_entry_data = (uint8_t *)(hash_entry_key + hash_table->key_size);
+  /* Start the other ranges, a range whose thread fails runs inline below */
+  for (i = 1; i < threads; i++)
+  {
+    started[i] = !pthread_create(&thread_ids[i], NULL, ht_iter_worker,
+        &workers[i]);
+  }
 
-      memcpy(key, hash_entry_key, hash_table->key_size);
-      memcpy(data, hash_entry_data, hash_table->data_size);
-      ht_iterator->current++;
-      return (1);
+  ht_iter_worker(&workers[0]);
+
+  for (i = 1; i < threads; i++)
+  {
+    if (started[i]) {
+      pthread_join(thread_ids[i], NULL);
+    } else {
+      ht_iter_worker(&workers[i]);
     }
   }
 
-  return (0);
+  return (1);
 }
@@ -0,0 +1,496 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_qf.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_qf.h"
+
+/**
+ * @brief Slot metadata bits, below the remainder
+ *
+ * Occupied belongs to the slot position: some fingerprint has this slot as
+ * its quotient. Continuation and shifted move with the remainder: the
+ * remainder is not the first of its run, and it is not in its quotient
+ * slot.
+ *
+ */
+enum {
+  HT_QF_OCCUPIED = 1,
+  HT_QF_CONTINUATION = 2,
+  HT_QF_SHIFTED = 4,
+};
+
+
+/**
+ * @brief Function to read a slot
+ *
+ * @param qf Quotient filter pointer
+ * @param index Slot index
+ * @return uint64_t Slot, metadata in the low bits and remainder above
+ */
+static inline uint64_t ht_qf_get(ht_qf_t *qf, uint32_t index)
+{
+  uint32_t bits;
+  uint64_t offset;
+  uint64_t slot;
+
+  bits = qf->remainder_bits + HT_QF_METADATA_BITS;
+  offset = (uint64_t)index * bits;
+
+  slot = qf->slots[offset / 64] >> (offset % 64);
+  if (offset % 64 + bits > 64) {
+    slot |= qf->slots[offset / 64 + 1] << (64 - offset % 64);
+  }
+
+  return (slot & (((uint64_t)1 << bits) - 1));
+}
+
+
+/**
+ * @brief Function to write a slot
+ *
+ * @param qf Quotient filter pointer
+ * @param index Slot index
+ * @param slot Slot, metadata in the low bits and remainder above
+ */
+static inline void ht_qf_set(ht_qf_t *qf, uint32_t index, uint64_t slot)
+{
+  uint32_t bits;
+  uint64_t mask;
+  uint64_t offset;
+
+  bits = qf->remainder_bits + HT_QF_METADATA_BITS;
+  offset = (uint64_t)index * bits;
+  mask = ((uint64_t)1 << bits) - 1;
+
+  qf->slots[offset / 64] &= ~(mask << (offset % 64));
+  qf->slots[offset / 64] |= slot << (offset % 64);
+  if (offset % 64 + bits > 64) {
+    qf->slots[offset / 64 + 1] &= ~(mask >> (64 - offset % 64));
+    qf->slots[offset / 64 + 1] |= slot >> (64 - offset % 64);
+  }
+}
+
+
+/**
+ * @brief Function to check if a slot holds no remainder
+ *
+ * @param slot Slot
+ * @return uint8_t 1 if the slot is empty else 0
+ */
+static inline uint8_t ht_qf_empty(uint64_t slot)
+{
+  return (!(slot & (HT_QF_OCCUPIED | HT_QF_CONTINUATION | HT_QF_SHIFTED)));
+}
+
+
+/**
+ * @brief Function to get the next slot index
+ *
+ * @param qf Quotient filter pointer
+ * @param index Slot index
+ * @return uint32_t Next slot index
+ */
+static inline uint32_t ht_qf_next(ht_qf_t *qf, uint32_t index)
+{
+  return ((index + 1) & (qf->size - 1));
+}
+
+
+/**
+ * @brief Function to get the previous slot index
+ *
+ * @param qf Quotient filter pointer
+ * @param index Slot index
+ * @return uint32_t Previous slot index
+ */
+static inline uint32_t ht_qf_prev(ht_qf_t *qf, uint32_t index)
+{
+  return ((index - 1) & (qf->size - 1));
+}
+
+
+/**
+ * @brief Function to get the fingerprint of a key
+ *
+ * @param qf Quotient filter pointer
+ * @param key Key
+ * @param[out] quotient Quotient of the fingerprint
+ * @return uint64_t Remainder of the fingerprint
+ */
+static inline uint64_t ht_qf_fingerprint(ht_qf_t *qf, uint8_t *key,
+    uint32_t *quotient)
+{
+  uint32_t hash;
+  uint32_t fingerprint;
+
+  /* Keep the high bits of the hash, the low bits are left to the tables */
+  hash = qf->hash_function(key);
+  fingerprint = (uint32_t)((uint64_t)hash >>
+      (32 - qf->quotient_bits - qf->remainder_bits));
+
+  *quotient = (uint32_t)((uint64_t)fingerprint >> qf->remainder_bits);
+
+  return (fingerprint & (((uint64_t)1 << qf->remainder_bits) - 1));
+}
+
+
+/**
+ * @brief Function to find the first slot of the run of an occupied quotient
+ *
+ * @param qf Quotient filter pointer
+ * @param quotient Quotient, its occupied bit must be set
+ * @return uint32_t Index of the first slot of the run
+ */
+static uint32_t ht_qf_run_start(ht_qf_t *qf, uint32_t quotient)
+{
+  uint32_t run;
+  uint32_t index;
+
+  /* Walk back to the start of the cluster */
+  index = quotient;
+  while (ht_qf_get(qf, index) & HT_QF_SHIFTED)
+  {
+    index = ht_qf_prev(qf, index);
+  }
+
+  /* Skip one run for each occupied quotient until the quotient is reached */
+  run = index;
+  while (index != quotient)
+  {
+    do {
+      run = ht_qf_next(qf, run);
+    } while (ht_qf_get(qf, run) & HT_QF_CONTINUATION);
+
+    do {
+      index = ht_qf_next(qf, index);
+    } while (!(ht_qf_get(qf, index) & HT_QF_OCCUPIED));
+  }
+
+  return (run);
+}
+
+
+/**
+ * @brief Function to find a remainder in a run
+ *
+ * @param qf Quotient filter pointer
+ * @param run First slot of the run
+ * @param remainder Remainder
+ * @param[out] position Slot holding the remainder, or where it belongs
+ * @return uint8_t 1 if the remainder was found else 0
+ */
+static uint8_t ht_qf_find(ht_qf_t *qf, uint32_t run, uint64_t remainder,
+    uint32_t *position)
+{
+  uint64_t slot;
+
+  /* Runs are sorted, stop at the first remainder not smaller */
+  do {
+    slot = ht_qf_get(qf, run);
+    if ((slot >> HT_QF_METADATA_BITS) >= remainder) {
+      *position = run;
+      return ((slot >> HT_QF_METADATA_BITS) == remainder);
+    }
+
+    run = ht_qf_next(qf, run);
+  } while (ht_qf_get(qf, run) & HT_QF_CONTINUATION);
+
+  *position = run;
+
+  return (0);
+}
+
+
+/**
+ * @brief Function to insert a fingerprint
+ *
+ * @param qf Quotient filter pointer
+ * @param quotient Quotient
+ * @param remainder Remainder
+ * @return uint8_t 1 if the fingerprint was inserted else 0 if the filter is
+ * full
+ */
+static uint8_t ht_qf_insert_fingerprint(ht_qf_t *qf, uint32_t quotient,
+    uint64_t remainder)
+{
+  uint32_t run;
+  uint32_t index;
+  uint64_t slot;
+  uint64_t moved;
+
+  if (qf->count == qf->size) {
+    return (0);
+  }
+
+  slot = ht_qf_get(qf, quotient);
+
+  /* The quotient slot is free, the remainder goes right there */
+  if (ht_qf_empty(slot)) {
+    ht_qf_set(qf, quotient, (remainder << HT_QF_METADATA_BITS) |
+        HT_QF_OCCUPIED);
+    qf->count++;
+    return (1);
+  }
+
+  moved = remainder << HT_QF_METADATA_BITS;
+
+  if (slot & HT_QF_OCCUPIED) {
+    /* A copy of an existing remainder goes in front of it */
+    run = ht_qf_run_start(qf, quotient);
+    ht_qf_find(qf, run, remainder, &index);
+
+    /* A new first remainder turns the previous first into a continuation */
+    slot = ht_qf_get(qf, index);
+    if (index == run) {
+      slot |= HT_QF_CONTINUATION;
+    } else {
+      moved |= HT_QF_CONTINUATION;
+    }
+  } else {
+    /* A new run starts where the previous run of the cluster ends */
+    ht_qf_set(qf, quotient, slot | HT_QF_OCCUPIED);
+    index = ht_qf_run_start(qf, quotient);
+    slot = ht_qf_get(qf, index);
+  }
+
+  if (index != quotient) {
+    moved |= HT_QF_SHIFTED;
+  }
+
+  /* Shift every remainder up to the next empty slot by one */
+  for ( ; ; )
+  {
+    ht_qf_set(qf, index, moved | (ht_qf_get(qf, index) & HT_QF_OCCUPIED));
+    if (ht_qf_empty(slot)) {
+      break;
+    }
+
+    moved = (slot & ~(uint64_t)HT_QF_OCCUPIED) | HT_QF_SHIFTED;
+    index = ht_qf_next(qf, index);
+    slot = ht_qf_get(qf, index);
+  }
+
+  qf->count++;
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to insert the key of a hash_table item
+ *
+ * @param key Item key
+ * @param data Item data
+ * @param context Quotient filter pointer
+ * @return uint8_t HT_FOREACH_KEEP or HT_FOREACH_STOP if the filter is full
+ */
+static uint8_t ht_qf_build_item(uint8_t *key, uint8_t *data, void *context)
+{
+  ht_qf_t *qf;
+
+  (void)data;
+
+  qf = (ht_qf_t *)context;
+
+  if (!ht_qf_insert(qf, key)) {
+    return (HT_FOREACH_STOP);
+  }
+
+  return (HT_FOREACH_KEEP);
+}
+
+
+uint8_t ht_qf_init(ht_qf_t *qf, hash_function_t hash_function,
+    uint32_t quotient_bits, uint32_t remainder_bits, uint64_t *slots)
+{
+  if (!quotient_bits || !remainder_bits ||
+      quotient_bits + remainder_bits > 32) {
+    return (0);
+  }
+
+  qf->hash_function = hash_function;
+  qf->slots = slots;
+  qf->quotient_bits = quotient_bits;
+  qf->remainder_bits = remainder_bits;
+  qf->size = (uint32_t)1 << quotient_bits;
+  qf->count = 0;
+
+  memset(slots, 0,
+      HT_QF_WORDS(quotient_bits, remainder_bits) * sizeof(uint64_t));
+
+  return (1);
+}
+
+
+uint8_t ht_qf_insert(ht_qf_t *qf, uint8_t *key)
+{
+  uint32_t quotient;
+  uint64_t remainder;
+
+  remainder = ht_qf_fingerprint(qf, key, &quotient);
+
+  return (ht_qf_insert_fingerprint(qf, quotient, remainder));
+}
+
+
+uint8_t ht_qf_contains(ht_qf_t *qf, uint8_t *key)
+{
+  uint32_t index;
+  uint32_t quotient;
+  uint64_t remainder;
+
+  remainder = ht_qf_fingerprint(qf, key, &quotient);
+  if (!(ht_qf_get(qf, quotient) & HT_QF_OCCUPIED)) {
+    return (0);
+  }
+
+  return (ht_qf_find(qf, ht_qf_run_start(qf, quotient), remainder, &index));
+}
+
+
+uint8_t ht_qf_remove(ht_qf_t *qf, uint8_t *key)
+{
+  uint32_t run;
+  uint32_t index;
+  uint32_t next;
+  uint32_t quotient;
+  uint64_t next_slot;
+  uint64_t remainder;
+  uint8_t promoted = 0;
+
+  remainder = ht_qf_fingerprint(qf, key, &quotient);
+  if (!(ht_qf_get(qf, quotient) & HT_QF_OCCUPIED)) {
+    return (0);
+  }
+
+  run = ht_qf_run_start(qf, quotient);
+  if (!ht_qf_find(qf, run, remainder, &index)) {
+    return (0);
+  }
+
+  next = ht_qf_next(qf, index);
+  next_slot = ht_qf_get(qf, next);
+
+  if (index == run) {
+    if (next_slot & HT_QF_CONTINUATION) {
+      /* The second remainder becomes the first of the run */
+      next_slot &= ~(uint64_t)HT_QF_CONTINUATION;
+      promoted = 1;
+    } else {
+      /* The run is gone */
+      ht_qf_set(qf, quotient,
+          ht_qf_get(qf, quotient) & ~(uint64_t)HT_QF_OCCUPIED);
+    }
+  }
+
+  /*
+   * Shift the rest of the cluster back by one slot. The first remainder of
+   * each later run may land in its quotient slot, which clears its shifted
+   * bit; a remainder already in its quotient slot ends the cluster.
+   */
+  while (!ht_qf_empty(next_slot) && (next_slot & HT_QF_SHIFTED))
+  {
+    next_slot &= ~(uint64_t)HT_QF_OCCUPIED;
+
+    if (!(next_slot & HT_QF_CONTINUATION)) {
+      if (promoted) {
+        promoted = 0;
+      } else {
+        do {
+          quotient = ht_qf_next(qf, quotient);
+        } while (!(ht_qf_get(qf, quotient) & HT_QF_OCCUPIED));
+      }
+
+      if (index == quotient) {
+        next_slot &= ~(uint64_t)HT_QF_SHIFTED;
+      }
+    }
+
+    ht_qf_set(qf, index, next_slot | (ht_qf_get(qf, index) & HT_QF_OCCUPIED));
+
+    index = next;
+    next = ht_qf_next(qf, index);
+    next_slot = ht_qf_get(qf, next);
+  }
+
+  ht_qf_set(qf, index, ht_qf_get(qf, index) & HT_QF_OCCUPIED);
+  qf->count--;
+
+  return (1);
+}
+
+
+uint32_t ht_qf_count(ht_qf_t *qf)
+{
+  return (qf->count);
+}
+
+
+void ht_qf_foreach(ht_qf_t *qf, ht_qf_callback_t callback, void *context)
+{
+  uint32_t run = 0;
+  uint32_t quotient;
+  uint64_t slot;
+  uint8_t first = 1;
+
+  for (quotient = 0; quotient < qf->size; quotient++)
+  {
+    slot = ht_qf_get(qf, quotient);
+    if (!(slot & HT_QF_OCCUPIED)) {
+      continue;
+    }
+
+    /*
+     * A run starts in its quotient slot unless it was shifted, then it
+     * follows the previous run of the cluster.
+     */
+    if (first) {
+      run = ht_qf_run_start(qf, quotient);
+      first = 0;
+    } else if (!(slot & HT_QF_SHIFTED)) {
+      run = quotient;
+    }
+
+    do {
+      slot = ht_qf_get(qf, run);
+      callback((uint32_t)(((uint64_t)quotient << qf->remainder_bits) |
+          (slot >> HT_QF_METADATA_BITS)), context);
+      run = ht_qf_next(qf, run);
+    } while (ht_qf_get(qf, run) & HT_QF_CONTINUATION);
+  }
+}
+
+
+uint8_t ht_qf_build(ht_qf_t *qf, ht_t *hash_table)
+{
+  return (ht_foreach(hash_table, ht_qf_build_item, qf));
+}
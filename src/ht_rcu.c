@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_rcu.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <sched.h>
+
+#include "ht_rcu.h"
+
+uint8_t ht_rcu_init(ht_rcu_t *rcu, ht_t *hash_table, ht_rcu_reader_t *readers,
+    uint32_t reader_count)
+{
+  uint32_t i;
+
+  rcu->current = hash_table;
+  rcu->epoch = 1;
+  rcu->readers = readers;
+  rcu->reader_count = reader_count;
+
+  for (i = 0; i < reader_count; i++)
+  {
+    readers[i].epoch = 0;
+  }
+
+  return (1);
+}
+
+
+uint8_t ht_rcu_get(ht_rcu_t *rcu, uint32_t reader, uint8_t *key,
+    uint8_t *data)
+{
+  uint8_t found;
+  ht_t *hash_table;
+
+  hash_table = ht_rcu_read_lock(rcu, reader);
+  found = ht_peek(hash_table, key, data);
+  ht_rcu_read_unlock(rcu, reader);
+
+  return (found);
+}
+
+
+ht_t *ht_rcu_publish(ht_rcu_t *rcu, ht_t *hash_table)
+{
+  uint32_t i;
+  uint64_t epoch;
+  uint64_t reader_epoch;
+  ht_t *previous;
+
+  previous = __atomic_exchange_n(&rcu->current, hash_table, __ATOMIC_SEQ_CST);
+  epoch = __atomic_add_fetch(&rcu->epoch, 1, __ATOMIC_SEQ_CST);
+
+  /* Readers that announced an older epoch may still hold the previous table */
+  for (i = 0; i < rcu->reader_count; i++)
+  {
+    for ( ; ; )
+    {
+      reader_epoch = __atomic_load_n(&rcu->readers[i].epoch,
+          __ATOMIC_SEQ_CST);
+      if (!reader_epoch || reader_epoch >= epoch) {
+        break;
+      }
+
+      /* Let a preempted reader run and finish its read section */
+      sched_yield();
+    }
+  }
+
+  return (previous);
+}
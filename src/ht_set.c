@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_set.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_set.h"
+
+
+/**
+ * @brief Function to get the state of an entry
+ *
+ * @param set Set pointer
+ * @param index Entry index
+ * @return uint8_t HT_SET_EMPTY, HT_SET_USED or HT_SET_DELETED
+ */
+static inline uint8_t ht_set_state(ht_set_t *set, uint32_t index)
+{
+  return ((set->control[index / 4] >> ((index % 4) * 2)) & 3);
+}
+
+
+/**
+ * @brief Function to change the state of an entry
+ *
+ * @param set Set pointer
+ * @param index Entry index
+ * @param state New state
+ */
+static inline void ht_set_state_store(ht_set_t *set, uint32_t index,
+    uint8_t state)
+{
+  uint8_t shift;
+
+  shift = (index % 4) * 2;
+  set->control[index / 4] =
+      (set->control[index / 4] & ~(3 << shift)) | (state << shift);
+}
+
+
+/**
+ * @brief Function to find the entry of a key
+ *
+ * @param set Set pointer
+ * @param key Key
+ * @param[out] free_index First deleted or empty entry seen, size if none
+ * @return uint32_t Index of the entry holding the key or size if not found
+ */
+static uint32_t ht_set_find(ht_set_t *set, uint8_t *key,
+    uint32_t *free_index)
+{
+  uint32_t i;
+  uint32_t index;
+  uint8_t state;
+
+  *free_index = set->size;
+  index = set->hash_function(key) % set->size;
+
+  for (i = 0; i < set->size; i++)
+  {
+    state = ht_set_state(set, index);
+
+    if (state == HT_SET_USED) {
+      if (!memcmp(&set->keys[(size_t)index * set->key_size], key,
+          set->key_size)) {
+        return (index);
+      }
+    } else {
+      if (*free_index == set->size) {
+        *free_index = index;
+      }
+
+      /* Nothing was ever stored past an empty entry */
+      if (state == HT_SET_EMPTY) {
+        break;
+      }
+    }
+
+    index++;
+    if (index == set->size) {
+      index = 0;
+    }
+  }
+
+  return (set->size);
+}
+
+
+uint8_t ht_set_init(ht_set_t *set, hash_function_t hash_function,
+    uint32_t size, uint32_t key_size, uint8_t *data)
+{
+  if (!size) {
+    return (0);
+  }
+
+  set->hash_function = hash_function;
+  set->control = data;
+  set->keys = data + HT_SET_CONTROL_SIZE(size);
+  set->size = size;
+  set->count = 0;
+  set->key_size = key_size;
+
+  memset(set->control, 0, HT_SET_CONTROL_SIZE(size));
+
+  return (1);
+}
+
+
+uint8_t ht_set_add(ht_set_t *set, uint8_t *key)
+{
+  uint32_t index;
+  uint32_t free_index;
+
+  index = ht_set_find(set, key, &free_index);
+  if (index != set->size || free_index == set->size) {
+    return (0);
+  }
+
+  memcpy(&set->keys[(size_t)free_index * set->key_size], key, set->key_size);
+  ht_set_state_store(set, free_index, HT_SET_USED);
+  set->count++;
+
+  return (1);
+}
+
+
+uint8_t ht_set_contains(ht_set_t *set, uint8_t *key)
+{
+  uint32_t free_index;
+
+  return (ht_set_find(set, key, &free_index) != set->size);
+}
+
+
+uint8_t ht_set_remove(ht_set_t *set, uint8_t *key)
+{
+  uint32_t index;
+  uint32_t free_index;
+
+  index = ht_set_find(set, key, &free_index);
+  if (index == set->size) {
+    return (0);
+  }
+
+  set->count--;
+
+  /*
+   * Leave a tombstone unless the next entry is empty, then this entry and
+   * the tombstones right before it end no probe sequence and become empty.
+   */
+  if (ht_set_state(set, (index + 1) % set->size) != HT_SET_EMPTY) {
+    ht_set_state_store(set, index, HT_SET_DELETED);
+    return (1);
+  }
+
+  do {
+    ht_set_state_store(set, index, HT_SET_EMPTY);
+    index = index ? index - 1 : set->size - 1;
+  } while (ht_set_state(set, index) == HT_SET_DELETED);
+
+  return (1);
+}
+
+
+uint32_t ht_set_count(ht_set_t *set)
+{
+  return (set->count);
+}
@@ -0,0 +1,320 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_sharded.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "ht_sharded.h"
+
+/**
+ * @brief Linux memory policy binding to the given nodes
+ *
+ */
+#define HT_SHARDED_MPOL_BIND       2
+
+/**
+ * @brief Linux memory policy flag moving pages already allocated
+ *
+ */
+#define HT_SHARDED_MPOL_MF_MOVE    (1 << 1)
+
+
+/**
+ * @brief Function to push a message in a queue
+ *
+ * @param queue Queue pointer
+ * @param operation Operation
+ * @param key Key
+ * @param key_size Key size
+ * @param data Data
+ * @param data_size Data size
+ * @return uint8_t 1 if the message was pushed else 0 if the queue is full
+ */
+static uint8_t ht_spsc_push(ht_spsc_t *queue, uint8_t operation, uint8_t *key,
+    uint32_t key_size, uint8_t *data, uint32_t data_size)
+{
+  uint32_t head;
+  uint32_t tail;
+  uint8_t *message;
+
+  tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+  if (tail - head == queue->size) {
+    return (0);
+  }
+
+  message = queue->data +
+      (uintptr_t)(tail & (queue->size - 1)) * queue->message_size;
+  message[0] = operation;
+  memcpy(message + 1, key, key_size);
+  if (data) {
+    memcpy(message + 1 + key_size, data, data_size);
+  }
+
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+
+  return (1);
+}
+
+
+/**
+ * @brief Function to peek the oldest message in a queue
+ *
+ * @param queue Queue pointer
+ * @return uint8_t* A pointer to the message or NULL if the queue is empty
+ */
+static uint8_t *ht_spsc_peek(ht_spsc_t *queue)
+{
+  uint32_t head;
+  uint32_t tail;
+
+  head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+  if (head == tail) {
+    return (NULL);
+  }
+
+  return (queue->data +
+         (uintptr_t)(head & (queue->size - 1)) * queue->message_size);
+}
+
+
+/**
+ * @brief Function to release the message returned by ht_spsc_peek
+ *
+ * @param queue Queue pointer
+ */
+static void ht_spsc_pop(ht_spsc_t *queue)
+{
+  uint32_t head;
+
+  head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+uint8_t ht_sharded_init(ht_sharded_t *sharded, ht_t *shards,
+    uint32_t shard_count)
+{
+  if (!shard_count) {
+    return (0);
+  }
+
+  sharded->shards = shards;
+  sharded->shard_count = shard_count;
+  sharded->queues = NULL;
+  sharded->producer_count = 0;
+  sharded->cursors = NULL;
+
+  return (1);
+}
+
+
+uint8_t ht_sharded_bind(uint8_t *data, size_t length, uint32_t node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  unsigned long nodemask[4];
+
+  if (node >= sizeof(nodemask) * 8) {
+    return (0);
+  }
+
+  memset(nodemask, 0, sizeof(nodemask));
+  nodemask[node / (sizeof(unsigned long) * 8)] =
+      1UL << (node % (sizeof(unsigned long) * 8));
+
+  /* The kernel only reads maxnode - 1 bits of the mask */
+  return (syscall(SYS_mbind, data, length, HT_SHARDED_MPOL_BIND, nodemask,
+         sizeof(nodemask) * 8 + 1, HT_SHARDED_MPOL_MF_MOVE) == 0);
+#else
+  (void)data;
+  (void)length;
+  (void)node;
+
+  return (0);
+#endif
+}
+
+
+uint32_t ht_sharded_shard(ht_sharded_t *sharded, uint8_t *key)
+{
+  uint32_t hash;
+
+  hash = sharded->shards[0].hash_function(key);
+
+  /* Scale the hash to the shard count so its high bits pick the shard */
+  return ((uint32_t)(((uint64_t)hash * sharded->shard_count) >> 32));
+}
+
+
+uint8_t ht_sharded_insert(ht_sharded_t *sharded, uint8_t *key, uint8_t *data)
+{
+  return (ht_insert(&sharded->shards[ht_sharded_shard(sharded, key)], key,
+         data));
+}
+
+
+uint8_t ht_sharded_remove(ht_sharded_t *sharded, uint8_t *key, uint8_t *data)
+{
+  return (ht_remove(&sharded->shards[ht_sharded_shard(sharded, key)], key,
+         data));
+}
+
+
+uint8_t ht_sharded_get(ht_sharded_t *sharded, uint8_t *key, uint8_t *data)
+{
+  return (ht_get_optimistic(&sharded->shards[ht_sharded_shard(sharded, key)],
+         key, data));
+}
+
+
+uint8_t ht_spsc_init(ht_spsc_t *queue, uint8_t *data, uint32_t size,
+    uint32_t message_size)
+{
+  /* Size must be a power of two so the indexes can wrap freely */
+  if (!size || (size & (size - 1))) {
+    return (0);
+  }
+
+  queue->data = data;
+  queue->size = size;
+  queue->message_size = message_size;
+  queue->head = 0;
+  queue->tail = 0;
+
+  return (1);
+}
+
+
+uint8_t ht_sharded_set_queues(ht_sharded_t *sharded, ht_spsc_t *queues,
+    uint32_t producer_count, uint32_t *cursors)
+{
+  uint32_t i;
+  uint32_t message_size;
+
+  message_size = HT_SHARDED_MESSAGE_SIZE(sharded->shards[0].key_size,
+      sharded->shards[0].data_size);
+
+  for (i = 0; i < producer_count * sharded->shard_count; i++)
+  {
+    if (queues[i].message_size < message_size) {
+      return (0);
+    }
+  }
+
+  memset(cursors, 0, sharded->shard_count * sizeof(uint32_t));
+
+  sharded->queues = queues;
+  sharded->producer_count = producer_count;
+  sharded->cursors = cursors;
+
+  return (1);
+}
+
+
+uint8_t ht_sharded_submit(ht_sharded_t *sharded, uint32_t producer,
+    uint8_t operation, uint8_t *key, uint8_t *data)
+{
+  uint32_t shard;
+  ht_spsc_t *queue;
+
+  shard = ht_sharded_shard(sharded, key);
+  queue = &sharded->queues[producer * sharded->shard_count + shard];
+
+  return (ht_spsc_push(queue, operation, key, sharded->shards[shard].key_size,
+         operation == HT_SHARDED_INSERT ? data : NULL,
+         sharded->shards[shard].data_size));
+}
+
+
+uint32_t ht_sharded_drain(ht_sharded_t *sharded, uint32_t shard,
+    uint32_t max, uint32_t *failed)
+{
+  uint8_t applied;
+  uint32_t idle;
+  uint32_t count;
+  uint32_t refused;
+  uint32_t producer;
+  uint8_t *message;
+  uint8_t *key;
+  ht_t *hash_table;
+  ht_spsc_t *queue;
+
+  idle = 0;
+  count = 0;
+  refused = 0;
+  hash_table = &sharded->shards[shard];
+  producer = sharded->cursors ? sharded->cursors[shard] : 0;
+
+  /* Take one message from every producer in turn until all are empty */
+  while (count < max && idle < sharded->producer_count)
+  {
+    queue = &sharded->queues[producer * sharded->shard_count + shard];
+
+    message = ht_spsc_peek(queue);
+    if (message) {
+      key = message + 1;
+
+      if (message[0] == HT_SHARDED_INSERT) {
+        applied = ht_insert(hash_table, key, key + hash_table->key_size);
+      } else {
+        applied = ht_remove(hash_table, key, NULL);
+      }
+
+      ht_spsc_pop(queue);
+      refused += !applied;
+      count++;
+      idle = 0;
+    } else {
+      idle++;
+    }
+
+    producer++;
+    if (producer == sharded->producer_count) {
+      producer = 0;
+    }
+  }
+
+  if (sharded->cursors) {
+    sharded->cursors[shard] = producer;
+  }
+
+  if (failed) {
+    *failed = refused;
+  }
+
+  return (count);
+}
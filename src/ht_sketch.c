@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_sketch.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_sketch.h"
+
+/**
+ * @brief Odd multipliers deriving an independent hash for each row
+ *
+ */
+static const uint32_t ht_sketch_seeds[HT_SKETCH_DEPTH] = {
+  0x9e3779b1u, 0x85ebca77u, 0xc2b2ae3du, 0x27d4eb2fu,
+};
+
+
+/**
+ * @brief Function to get the counter of a hash in a row
+ *
+ * @param sketch Sketch pointer
+ * @param row Row index
+ * @param hash Hash of the key
+ * @param[out] shift Position of the counter in the byte returned
+ * @return uint8_t* A pointer to the byte holding the counter
+ */
+static inline uint8_t *ht_sketch_counter(ht_sketch_t *sketch, uint32_t row,
+    uint32_t hash, uint32_t *shift)
+{
+  uint32_t index;
+
+  /* Mix the hash for the row and map it to a counter without a modulo */
+  hash *= ht_sketch_seeds[row];
+  hash ^= hash >> 15;
+  index = (uint32_t)(((uint64_t)hash * sketch->width) >> 32);
+
+  *shift = (index & 1) * 4;
+
+  return (&sketch->counters[row * ((sketch->width + 1) / 2) + index / 2]);
+}
+
+
+uint8_t ht_sketch_init(ht_sketch_t *sketch, uint32_t width,
+    uint8_t *counters)
+{
+  if (!width) {
+    return (0);
+  }
+
+  sketch->counters = counters;
+  sketch->width = width;
+  sketch->additions = 0;
+  sketch->sample_size = width * 10;
+
+  memset(counters, 0, HT_SKETCH_SIZE(width));
+
+  return (1);
+}
+
+
+void ht_sketch_increment(ht_sketch_t *sketch, uint32_t hash)
+{
+  uint32_t i;
+  uint32_t shift;
+  uint8_t *counter;
+
+  for (i = 0; i < HT_SKETCH_DEPTH; i++)
+  {
+    counter = ht_sketch_counter(sketch, i, hash, &shift);
+    if (((*counter >> shift) & 0xf) < HT_SKETCH_MAX) {
+      *counter += 1 << shift;
+    }
+  }
+
+  if (++sketch->additions >= sketch->sample_size) {
+    ht_sketch_age(sketch);
+  }
+}
+
+
+uint8_t ht_sketch_estimate(ht_sketch_t *sketch, uint32_t hash)
+{
+  uint32_t i;
+  uint32_t shift;
+  uint8_t value;
+  uint8_t estimate = HT_SKETCH_MAX;
+  uint8_t *counter;
+
+  for (i = 0; i < HT_SKETCH_DEPTH; i++)
+  {
+    counter = ht_sketch_counter(sketch, i, hash, &shift);
+    value = (*counter >> shift) & 0xf;
+    if (value < estimate) {
+      estimate = value;
+    }
+  }
+
+  return (estimate);
+}
+
+
+void ht_sketch_age(ht_sketch_t *sketch)
+{
+  uint32_t i;
+
+  /* Halve both counters of each byte at once */
+  for (i = 0; i < HT_SKETCH_SIZE(sketch->width); i++)
+  {
+    sketch->counters[i] = (sketch->counters[i] >> 1) & 0x77;
+  }
+
+  sketch->additions /= 2;
+}
@@ -0,0 +1,299 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_stats.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "ht_stats.h"
+
+/**
+ * @brief Statistics of a range of entries
+ *
+ */
+typedef struct {
+  /**
+   * @brief Pointer to the hash table
+   *
+   */
+  ht_t *                hash_table;
+
+  /**
+   * @brief Index of the first entry of the range
+   *
+   */
+  uint32_t              start;
+
+  /**
+   * @brief Index where the range stops
+   *
+   */
+  uint32_t              end;
+
+  /**
+   * @brief Statistics of the range
+   *
+   */
+  ht_stats_t            stats;
+
+  /**
+   * @brief Number of used or removed entries at the start of the range
+   *
+   */
+  uint32_t              prefix;
+
+  /**
+   * @brief Number of used or removed entries at the end of the range
+   *
+   */
+  uint32_t              suffix;
+} ht_stats_range_t;
+
+
+/**
+ * @brief Function to scan the entries of a range
+ *
+ * @param arg Range pointer
+ * @return void* Always NULL
+ */
+static void *ht_stats_worker(void *arg)
+{
+  uint32_t hash;
+  uint32_t index;
+  uint32_t run;
+  uint32_t distance;
+  uint8_t empty_seen;
+  ht_entry_t *hash_entry;
+  ht_stats_range_t *range;
+  ht_t *hash_table;
+
+  range = (ht_stats_range_t *)arg;
+  hash_table = range->hash_table;
+
+  run = 0;
+  empty_seen = 0;
+  for (index = range->start; index < range->end; index++)
+  {
+    hash_entry = ht_entry_get(hash_table, index);
+
+    if (ht_entry_used(hash_table, hash_entry)) {
+      hash = ht_hash(hash_table, (uint8_t *)(hash_entry +
+          sizeof(ht_entry_t)));
+      /* Other probe sequences are walked up to the entry of the item */
+      if (hash_table->probe == HT_PROBE_LINEAR) {
+        distance = (index + hash_table->size - hash % hash_table->size) %
+            hash_table->size;
+      } else {
+        distance = 0;
+        while (distance < hash_table->size &&
+               ht_probe_index(hash_table, hash, distance) != index)
+        {
+          distance++;
+        }
+      }
+
+      range->stats.count++;
+      range->stats.probe_total += distance;
+      if (distance > range->stats.max_probe) {
+        range->stats.max_probe = distance;
+      }
+      if (distance >= HT_STATS_HISTOGRAM_SIZE) {
+        distance = HT_STATS_HISTOGRAM_SIZE - 1;
+      }
+      range->stats.histogram[distance]++;
+      run++;
+    } else if (ht_entry_deleted(hash_table, hash_entry)) {
+      range->stats.tombstones++;
+      run++;
+    } else {
+      /* An empty entry ends the cluster */
+      if (!empty_seen) {
+        range->prefix = run;
+        empty_seen = 1;
+      }
+      if (run > range->stats.largest_cluster) {
+        range->stats.largest_cluster = run;
+      }
+      run = 0;
+    }
+  }
+
+  /* Clusters crossing the range boundaries are joined by the caller */
+  if (!empty_seen) {
+    range->prefix = run;
+  }
+  if (run > range->stats.largest_cluster) {
+    range->stats.largest_cluster = run;
+  }
+  range->suffix = run;
+
+  return (NULL);
+}
+
+
+/**
+ * @brief Function to add the statistics of a range to the ones before it
+ *
+ * @param stats Statistics of the ranges before
+ * @param range Range that follows them
+ * @param[in,out] prefix Used or removed entries at the start of the ranges
+ * @param[in,out] suffix Used or removed entries at the end of the ranges
+ */
+static void ht_stats_merge(ht_stats_t *stats, ht_stats_range_t *range,
+    uint32_t *prefix, uint32_t *suffix)
+{
+  uint32_t i;
+  uint32_t length;
+
+  length = range->end - range->start;
+
+  stats->count += range->stats.count;
+  stats->tombstones += range->stats.tombstones;
+  stats->probe_total += range->stats.probe_total;
+  if (range->stats.max_probe > stats->max_probe) {
+    stats->max_probe = range->stats.max_probe;
+  }
+  for (i = 0; i < HT_STATS_HISTOGRAM_SIZE; i++)
+  {
+    stats->histogram[i] += range->stats.histogram[i];
+  }
+
+  if (range->stats.largest_cluster > stats->largest_cluster) {
+    stats->largest_cluster = range->stats.largest_cluster;
+  }
+  if (*suffix + range->prefix > stats->largest_cluster) {
+    stats->largest_cluster = *suffix + range->prefix;
+  }
+
+  /* A range without empty entries extends the clusters around it */
+  if (*prefix == range->start) {
+    *prefix += range->prefix;
+  }
+  if (range->suffix == length) {
+    *suffix += length;
+  } else {
+    *suffix = range->suffix;
+  }
+}
+
+
+uint8_t ht_stats(ht_t *hash_table, ht_stats_t *stats)
+{
+  return (ht_stats_parallel(hash_table, 1, stats));
+}
+
+
+uint8_t ht_stats_parallel(ht_t *hash_table, uint32_t threads,
+    ht_stats_t *stats)
+{
+  uint32_t i;
+  uint32_t prefix;
+  uint32_t suffix;
+  uint64_t entry_size;
+  uint8_t started[HT_STATS_MAX_THREADS];
+  pthread_t thread_ids[HT_STATS_MAX_THREADS];
+  ht_stats_range_t ranges[HT_STATS_MAX_THREADS];
+
+  if (!threads || threads > HT_STATS_MAX_THREADS || !hash_table->size) {
+    return (0);
+  }
+
+  for (i = 0; i < threads; i++)
+  {
+    memset(&ranges[i], 0, sizeof(ranges[i]));
+    ranges[i].hash_table = hash_table;
+    ranges[i].start =
+        (uint32_t)(((uint64_t)hash_table->size * i) / threads);
+    ranges[i].end =
+        (uint32_t)(((uint64_t)hash_table->size * (i + 1)) / threads);
+  }
+
+  /* Start the other ranges, a range whose thread fails runs inline below */
+  for (i = 1; i < threads; i++)
+  {
+    started[i] = !pthread_create(&thread_ids[i], NULL, ht_stats_worker,
+        &ranges[i]);
+  }
+
+  ht_stats_worker(&ranges[0]);
+
+  for (i = 1; i < threads; i++)
+  {
+    if (started[i]) {
+      pthread_join(thread_ids[i], NULL);
+    } else {
+      ht_stats_worker(&ranges[i]);
+    }
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  prefix = 0;
+  suffix = 0;
+  for (i = 0; i < threads; i++)
+  {
+    ht_stats_merge(stats, &ranges[i], &prefix, &suffix);
+  }
+
+  /* The last cluster wraps around to the first entries */
+  if (prefix == hash_table->size) {
+    stats->largest_cluster = hash_table->size;
+  } else if (suffix + prefix > stats->largest_cluster) {
+    stats->largest_cluster = suffix + prefix;
+  }
+
+  entry_size = sizeof(ht_entry_t) + hash_table->key_size +
+      hash_table->data_size;
+
+  stats->size = hash_table->size;
+  stats->load_factor =
+      (uint32_t)(((uint64_t)stats->count * 1000) / hash_table->size);
+  if (stats->count) {
+    stats->mean_probe =
+        (uint32_t)((stats->probe_total * 1000) / stats->count);
+  }
+  stats->bytes_used = stats->count * entry_size;
+  stats->bytes_allocated = hash_table->size * entry_size;
+  if (hash_table->occupancy) {
+    stats->bytes_allocated +=
+        HT_OCCUPANCY_WORDS(hash_table->size) * sizeof(uint64_t);
+  }
+  if (hash_table->expiry) {
+    stats->bytes_allocated += hash_table->size * sizeof(uint32_t);
+  }
+  if (hash_table->sketch) {
+    stats->bytes_allocated += HT_SKETCH_SIZE(hash_table->sketch->width);
+  }
+  if (hash_table->bloom) {
+    stats->bytes_allocated +=
+        HT_BLOOM_WORDS(hash_table->bloom->block_count) * sizeof(uint64_t);
+  }
+
+  return (1);
+}
@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/**
+ * @file ht_trace.c
+ *
+ * @author Yago Fontoura do Rosario <yago.rosario@hotmail.com.br>
+ */
+
+#include <string.h>
+
+#include "ht_trace.h"
+
+
+uint8_t ht_trace_init(ht_trace_t *trace, uint8_t *buffer,
+    uint32_t buffer_size, ht_trace_write_function_t write_function,
+    void *context)
+{
+  if (buffer_size < HT_TRACE_MAGIC_SIZE) {
+    return (0);
+  }
+
+  trace->buffer = buffer;
+  trace->buffer_size = buffer_size;
+  trace->write_function = write_function;
+  trace->context = context;
+  trace->records = 0;
+  trace->pending = 0;
+  trace->dropped = 0;
+
+  memcpy(buffer, HT_TRACE_MAGIC, HT_TRACE_MAGIC_SIZE);
+  trace->used = HT_TRACE_MAGIC_SIZE;
+
+  return (1);
+}
+
+
+uint8_t ht_trace_record(ht_trace_t *trace, uint8_t operation, uint8_t *key,
+    uint32_t key_size, uint32_t data_size)
+{
+  uint8_t *record;
+
+  if (key_size > UINT16_MAX ||
+      HT_TRACE_RECORD_SIZE(key_size) > trace->buffer_size) {
+    trace->dropped++;
+    return (0);
+  }
+
+  if (trace->used + HT_TRACE_RECORD_SIZE(key_size) > trace->buffer_size) {
+    ht_trace_flush(trace);
+  }
+
+  record = trace->buffer + trace->used;
+  record[0] = operation;
+  record[1] = (uint8_t)key_size;
+  record[2] = (uint8_t)(key_size >> 8);
+  record[3] = (uint8_t)data_size;
+  record[4] = (uint8_t)(data_size >> 8);
+  record[5] = (uint8_t)(data_size >> 16);
+  record[6] = (uint8_t)(data_size >> 24);
+  memcpy(record + HT_TRACE_HEADER_SIZE, key, key_size);
+
+  trace->used += HT_TRACE_RECORD_SIZE(key_size);
+  trace->pending++;
+
+  return (1);
+}
+
+
+uint8_t ht_trace_flush(ht_trace_t *trace)
+{
+  uint8_t written;
+
+  if (!trace->used) {
+    return (1);
+  }
+
+  /* Records that could not be written are lost, the buffer is reused */
+  written = trace->write_function(trace->buffer, trace->used,
+      trace->context);
+  if (written) {
+    trace->records += trace->pending;
+  } else {
+    trace->dropped += trace->pending;
+  }
+
+  trace->used = 0;
+  trace->pending = 0;
+
+  return (written);
+}
+
+
+uint8_t ht_trace_insert(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data)
+{
+  ht_trace_record(trace, HT_TRACE_INSERT, key, hash_table->key_size,
+      hash_table->data_size);
+
+  return (ht_insert(hash_table, key, data));
+}
+
+
+uint8_t ht_trace_get(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data)
+{
+  ht_trace_record(trace, HT_TRACE_GET, key, hash_table->key_size,
+      hash_table->data_size);
+
+  return (ht_get(hash_table, key, data));
+}
+
+
+uint8_t ht_trace_remove(ht_trace_t *trace, ht_t *hash_table, uint8_t *key,
+    uint8_t *data)
+{
+  ht_trace_record(trace, HT_TRACE_REMOVE, key, hash_table->key_size,
+      hash_table->data_size);
+
+  return (ht_remove(hash_table, key, data));
+}
+
+
+uint8_t ht_trace_reader_init(ht_trace_reader_t *reader, uint8_t *data,
+    uint64_t size)
+{
+  if (size < HT_TRACE_MAGIC_SIZE ||
+      memcmp(data, HT_TRACE_MAGIC, HT_TRACE_MAGIC_SIZE)) {
+    return (0);
+  }
+
+  reader->data = data;
+  reader->size = size;
+  reader->offset = HT_TRACE_MAGIC_SIZE;
+
+  return (1);
+}
+
+
+uint8_t ht_trace_reader_next(ht_trace_reader_t *reader,
+    ht_trace_record_t *record)
+{
+  uint8_t *data;
+
+  if (reader->size - reader->offset < HT_TRACE_HEADER_SIZE) {
+    return (0);
+  }
+
+  data = reader->data + reader->offset;
+  record->operation = data[0];
+  record->key_size = (uint16_t)(data[1] | (data[2] << 8));
+  record->data_size = (uint32_t)data[3] | ((uint32_t)data[4] << 8) |
+      ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 24);
+  record->key = data + HT_TRACE_HEADER_SIZE;
+
+  /* A truncated last record is ignored */
+  if (reader->size - reader->offset < HT_TRACE_RECORD_SIZE(record->key_size)) {
+    return (0);
+  }
+
+  reader->offset += HT_TRACE_RECORD_SIZE(record->key_size);
+
+  return (1);
+}
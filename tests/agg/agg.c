@@ -0,0 +1,251 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ht_agg.h"
+
+typedef struct {
+  uint32_t key;
+} agg_key_t;
+
+#define AGG_WORKERS            4
+#define AGG_PARTITIONS         8
+#define AGG_KEYS               1000
+#define AGG_ROWS               20000
+#define AGG_LOCAL_SIZE         512
+#define AGG_OUTPUT_SIZE        256
+#define AGG_ENTRY_SIZE         (sizeof(ht_entry_t) + sizeof(agg_key_t) + \
+    sizeof(uint64_t))
+
+static ht_agg_t agg;
+static ht_t tables[AGG_WORKERS * AGG_PARTITIONS];
+static uint8_t tables_data[AGG_WORKERS * AGG_PARTITIONS][AGG_ENTRY_SIZE *
+    AGG_LOCAL_SIZE];
+static ht_t outputs[AGG_PARTITIONS];
+static uint8_t outputs_data[AGG_PARTITIONS][AGG_ENTRY_SIZE *
+    AGG_OUTPUT_SIZE];
+static uint8_t records[AGG_KEYS * HT_AGG_RECORD_SIZE(sizeof(agg_key_t),
+    sizeof(uint64_t))];
+
+static uint32_t agg_hash_function(uint8_t *key)
+{
+  agg_key_t *agg_key;
+
+  agg_key = (agg_key_t *)key;
+
+  return (agg_key->key * 2654435761u);
+}
+
+
+static void *aggregate_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t worker;
+  agg_key_t agg_key;
+  uint64_t agg_data;
+
+  worker = (uint32_t)(uintptr_t)arg;
+
+  /* Each worker aggregates its own share of the rows */
+  for (i = worker; i < AGG_ROWS; i += AGG_WORKERS)
+  {
+    agg_key.key = i % AGG_KEYS;
+    agg_data = i;
+    if (!ht_agg_update(&agg, worker, (uint8_t *)&agg_key,
+        (uint8_t *)&agg_data)) {
+      return ((void *)1);
+    }
+  }
+
+  return (NULL);
+}
+
+
+void test_agg(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t count;
+  uint64_t expected;
+  void *result;
+  pthread_t threads[AGG_WORKERS];
+  agg_key_t agg_key;
+  uint64_t agg_data;
+
+  for (i = 0; i < AGG_WORKERS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, aggregate_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  for (i = 0; i < AGG_WORKERS; i++)
+  {
+    pthread_join(threads[i], &result);
+    assert_true(result == NULL);
+  }
+
+  assert_true(ht_agg_merge(&agg, outputs, AGG_WORKERS));
+
+  /* Every key is in the output of its partition with the sum of its rows */
+  count = 0;
+  for (i = 0; i < AGG_PARTITIONS; i++)
+  {
+    count += ht_count(&outputs[i]);
+  }
+  assert_true(count == AGG_KEYS);
+
+  for (i = 0; i < AGG_KEYS; i++)
+  {
+    agg_key.key = i;
+    assert_true(ht_get(&outputs[ht_agg_partition(&agg, (uint8_t *)&agg_key)],
+        (uint8_t *)&agg_key, (uint8_t *)&agg_data));
+
+    expected = (uint64_t)i * (AGG_ROWS / AGG_KEYS) +
+        (uint64_t)AGG_KEYS * (AGG_ROWS / AGG_KEYS) *
+        (AGG_ROWS / AGG_KEYS - 1) / 2;
+    assert_true(agg_data == expected);
+  }
+
+  /* Flatten the partitions into one array */
+  assert_true(ht_agg_collect(&agg, outputs, 3, records) == AGG_KEYS);
+
+  expected = 0;
+  for (i = 0; i < AGG_KEYS; i++)
+  {
+    memcpy(&agg_key, &records[i * HT_AGG_RECORD_SIZE(sizeof(agg_key_t),
+        sizeof(uint64_t))], sizeof(agg_key));
+    memcpy(&agg_data, &records[i * HT_AGG_RECORD_SIZE(sizeof(agg_key_t),
+        sizeof(uint64_t)) + sizeof(agg_key_t)], sizeof(agg_data));
+    expected += agg_key.key;
+    assert_true(agg_data == (uint64_t)agg_key.key * (AGG_ROWS / AGG_KEYS) +
+        (uint64_t)AGG_KEYS * (AGG_ROWS / AGG_KEYS) *
+        (AGG_ROWS / AGG_KEYS - 1) / 2);
+  }
+  assert_true(expected == (uint64_t)AGG_KEYS * (AGG_KEYS - 1) / 2);
+}
+
+
+void test_agg_full(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  agg_key_t agg_key;
+  uint64_t agg_data = 1;
+
+  agg_key.key = 0;
+  assert_false(ht_agg_update(&agg, AGG_WORKERS, (uint8_t *)&agg_key,
+      (uint8_t *)&agg_data));
+  assert_false(ht_agg_merge(&agg, outputs, 0));
+  assert_false(ht_agg_merge(&agg, outputs, HT_AGG_MAX_THREADS + 1));
+
+  /* Fill a single worker with more keys than one output can hold */
+  for (i = 0; i < AGG_OUTPUT_SIZE * AGG_PARTITIONS * 2; i++)
+  {
+    agg_key.key = i;
+    ht_agg_update(&agg, 0, (uint8_t *)&agg_key, (uint8_t *)&agg_data);
+  }
+
+  assert_false(ht_agg_merge(&agg, outputs, 2));
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+
+  memset(tables_data, 0, sizeof(tables_data));
+  memset(outputs_data, 0, sizeof(outputs_data));
+
+  for (i = 0; i < AGG_WORKERS * AGG_PARTITIONS; i++)
+  {
+    assert_true(ht_init(&tables[i], agg_hash_function, AGG_LOCAL_SIZE,
+        sizeof(uint64_t), sizeof(agg_key_t), tables_data[i]));
+  }
+
+  for (i = 0; i < AGG_PARTITIONS; i++)
+  {
+    assert_true(ht_init(&outputs[i], agg_hash_function, AGG_OUTPUT_SIZE,
+        sizeof(uint64_t), sizeof(agg_key_t), outputs_data[i]));
+  }
+
+  assert_false(ht_agg_init(&agg, tables, 0, AGG_PARTITIONS,
+      ht_combine_add));
+  assert_true(ht_agg_init(&agg, tables, AGG_WORKERS, AGG_PARTITIONS,
+      ht_combine_add));
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_agg,      setup, teardown),
+    cmocka_unit_test_setup_teardown(test_agg_full, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
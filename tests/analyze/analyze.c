@@ -0,0 +1,221 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_analyze.h"
+
+typedef struct {
+  uint32_t key;
+} analyze_key_t;
+
+#define ANALYZE_KEYS            1000
+#define ANALYZE_ENTRIES_SIZE    2000
+
+static analyze_key_t analyze_keys[ANALYZE_KEYS];
+static uint32_t analyze_work[ANALYZE_ENTRIES_SIZE];
+
+static uint32_t analyze_identity_hash_function(uint8_t *key)
+{
+  analyze_key_t *analyze_key;
+
+  analyze_key = (analyze_key_t *)key;
+
+  return (analyze_key->key);
+}
+
+
+static uint32_t analyze_basic_hash_function(uint8_t *key)
+{
+  analyze_key_t *analyze_key;
+
+  analyze_key = (analyze_key_t *)key;
+
+  /* Same hash as the basic test */
+  return ((analyze_key->key * 32) >> 8);
+}
+
+
+static uint32_t analyze_murmur3_hash_function(uint8_t *key)
+{
+  uint32_t hash;
+  analyze_key_t *analyze_key;
+
+  analyze_key = (analyze_key_t *)key;
+
+  hash = analyze_key->key;
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+
+  return (hash);
+}
+
+
+void test_analyze(void **state)
+{
+  (void)state;
+
+  ht_analyze_t analyze;
+
+  /* Keys 0 and 1 in 4 entries */
+  assert_true(ht_analyze(analyze_identity_hash_function,
+      (uint8_t *)analyze_keys, 2, sizeof(analyze_key_t), 4, analyze_work,
+      &analyze));
+  assert_true(analyze.size == 4);
+  assert_true(analyze.count == 2);
+  assert_true(analyze.chi_square == 2000);
+  assert_true(analyze.probe_hit == 1000);
+  assert_true(analyze.probe_hit_expected == 1500);
+  assert_true(analyze.probe_miss == 1750);
+  assert_true(analyze.probe_miss_expected == 2500);
+  assert_true(analyze.max_probe == 0);
+  assert_true(analyze.clusters == 1);
+  assert_true(analyze.largest_cluster == 2);
+  assert_true(analyze.cluster_histogram[1] == 1);
+
+  /* Each key bit changes exactly one hash bit */
+  assert_true(analyze.avalanche_mean == 31);
+  assert_true(analyze.avalanche_bias == 500);
+
+  /* A full table */
+  assert_true(ht_analyze(analyze_identity_hash_function,
+      (uint8_t *)analyze_keys, 4, sizeof(analyze_key_t), 4, analyze_work,
+      &analyze));
+  assert_true(analyze.clusters == 1);
+  assert_true(analyze.largest_cluster == 4);
+  assert_true(analyze.probe_miss == UINT32_MAX);
+  assert_true(analyze.probe_miss_expected == UINT32_MAX);
+
+  /* More keys than entries */
+  assert_false(ht_analyze(analyze_identity_hash_function,
+      (uint8_t *)analyze_keys, 5, sizeof(analyze_key_t), 4, analyze_work,
+      &analyze));
+  assert_false(ht_analyze(analyze_identity_hash_function,
+      (uint8_t *)analyze_keys, 0, sizeof(analyze_key_t), 4, analyze_work,
+      &analyze));
+}
+
+
+void test_analyze_quality(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  ht_analyze_t basic;
+  ht_analyze_t murmur3;
+
+  assert_true(ht_analyze(analyze_basic_hash_function,
+      (uint8_t *)analyze_keys, ANALYZE_KEYS, sizeof(analyze_key_t),
+      ANALYZE_ENTRIES_SIZE, analyze_work, &basic));
+  assert_true(ht_analyze(analyze_murmur3_hash_function,
+      (uint8_t *)analyze_keys, ANALYZE_KEYS, sizeof(analyze_key_t),
+      ANALYZE_ENTRIES_SIZE, analyze_work, &murmur3));
+
+  /* The keys are restored after the avalanche test */
+  for (i = 0; i < ANALYZE_KEYS; i++)
+  {
+    assert_true(analyze_keys[i].key == i);
+  }
+
+  /* Groups of 8 keys share a hash, the table is one long cluster */
+  assert_true(basic.chi_square > 5 * murmur3.chi_square);
+  assert_true(basic.avalanche_bias == 500);
+  assert_true(basic.max_probe >= 7);
+  assert_true(basic.largest_cluster == ANALYZE_KEYS);
+  assert_true(basic.probe_miss > 2 * basic.probe_miss_expected);
+
+  /* A good hash is close to the expected values */
+  assert_true(murmur3.chi_square < (uint64_t)ANALYZE_ENTRIES_SIZE * 1500);
+  assert_true(murmur3.avalanche_mean > 450 && murmur3.avalanche_mean < 550);
+  assert_true(murmur3.avalanche_bias < 100);
+  assert_true(murmur3.probe_hit < 2 * murmur3.probe_hit_expected);
+  assert_true(murmur3.probe_miss < 2 * murmur3.probe_miss_expected);
+  assert_true(murmur3.largest_cluster < 50);
+  assert_true(murmur3.clusters > 100);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+
+  for (i = 0; i < ANALYZE_KEYS; i++)
+  {
+    analyze_keys[i].key = i;
+  }
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_analyze,         setup, teardown),
+    cmocka_unit_test_setup_teardown(test_analyze_quality, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
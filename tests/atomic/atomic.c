@@ -0,0 +1,445 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ht_atomic.h"
+
+typedef struct {
+  uint32_t key;
+} atomic_key_t;
+
+#define ATOMIC_HASH_ENTRIES_SIZE    4096
+#define ATOMIC_HASH_KEYS            2000
+#define ATOMIC_THREADS              4
+#define ATOMIC_CHURN_KEYS           (ATOMIC_HASH_ENTRIES_SIZE * 2)
+
+static ht_atomic_t hash_table;
+static uint64_t hash_table_data[(HT_ATOMIC_ENTRY_SIZE(sizeof(atomic_key_t)) *
+    ATOMIC_HASH_ENTRIES_SIZE) / sizeof(uint64_t)];
+static uint32_t inserted[ATOMIC_THREADS];
+static uint32_t removed[ATOMIC_THREADS];
+static uint32_t failed[ATOMIC_THREADS];
+static uint8_t churned[ATOMIC_CHURN_KEYS];
+
+static uint32_t atomic_hash_function(uint8_t *key)
+{
+  atomic_key_t *atomic_key;
+
+  atomic_key = (atomic_key_t *)key;
+
+  /* Keep neighbour keys in the same cluster to stress the probing */
+  return (atomic_key->key / 4);
+}
+
+
+static void *insert_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  inserted[thread] = 0;
+
+  /* Every thread races to insert the same keys */
+  for (i = 0; i < ATOMIC_HASH_KEYS; i++)
+  {
+    atomic_key.key = i;
+    atomic_data = (uint64_t)i * 3;
+    inserted[thread] += ht_atomic_insert(&hash_table,
+        (uint8_t *)&atomic_key, (uint8_t *)&atomic_data);
+  }
+
+  return (NULL);
+}
+
+
+static void *remove_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  inserted[thread] = 0;
+
+  /* Each thread removes its own share of the keys */
+  for (i = thread; i < ATOMIC_HASH_KEYS; i += ATOMIC_THREADS)
+  {
+    atomic_key.key = i;
+    if (ht_atomic_remove(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data) && atomic_data == (uint64_t)i * 3) {
+      inserted[thread]++;
+    }
+  }
+
+  return (NULL);
+}
+
+
+static void *accumulate_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  atomic_key_t atomic_key;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  inserted[thread] = 0;
+
+  /* Count every key from every thread, half of them are new */
+  for (i = ATOMIC_HASH_KEYS / 2; i < ATOMIC_HASH_KEYS * 3 / 2; i++)
+  {
+    atomic_key.key = i;
+    inserted[thread] += ht_atomic_accumulate(&hash_table,
+        (uint8_t *)&atomic_key, 1, HT_ATOMIC_ADD);
+  }
+
+  /* Keep the largest thread number seen */
+  atomic_key.key = ATOMIC_HASH_KEYS * 2;
+  ht_atomic_accumulate(&hash_table, (uint8_t *)&atomic_key, thread + 1,
+      HT_ATOMIC_MAX);
+
+  return (NULL);
+}
+
+
+static void *churn_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  inserted[thread] = 0;
+  removed[thread] = 0;
+  failed[thread] = 0;
+
+  /* Every thread inserts and removes the same keys, more than fit at once */
+  for (i = 0; i < ATOMIC_CHURN_KEYS; i++)
+  {
+    atomic_key.key = ATOMIC_HASH_KEYS * 4 + i;
+    atomic_data = atomic_key.key;
+    if (ht_atomic_insert(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data)) {
+      inserted[thread]++;
+      __atomic_store_n(&churned[i], 1, __ATOMIC_RELAXED);
+    }
+
+    ht_atomic_update(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data);
+    if (ht_atomic_remove(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data)) {
+      removed[thread]++;
+      failed[thread] += atomic_data != atomic_key.key;
+    }
+
+    /* Keys left in the table never see the data of a churned key */
+    atomic_key.key = i % ATOMIC_HASH_KEYS;
+    if (!ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data) || atomic_data != (uint64_t)i %
+        ATOMIC_HASH_KEYS * 3) {
+      failed[thread]++;
+    }
+  }
+
+  return (NULL);
+}
+
+
+void test_hash(void **state)
+{
+  (void)state;
+
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  /* Get item from hash_table and check content */
+  atomic_key.key = 10;
+  assert_true(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(atomic_data == 30);
+
+  /* Update it in place */
+  atomic_data = 7;
+  assert_true(ht_atomic_update(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(atomic_data == 7);
+
+  /* Remove it and try to remove it again */
+  assert_true(ht_atomic_remove(&hash_table, (uint8_t *)&atomic_key, NULL));
+  assert_false(ht_atomic_remove(&hash_table, (uint8_t *)&atomic_key, NULL));
+  assert_false(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_false(ht_atomic_update(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(ht_atomic_count(&hash_table) == ATOMIC_HASH_KEYS - 1);
+
+  /* Insert it back in its deleted entry */
+  atomic_data = 30;
+  assert_true(ht_atomic_insert(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(ht_atomic_count(&hash_table) == ATOMIC_HASH_KEYS);
+
+  /* Try to get item that was not added */
+  atomic_key.key = ATOMIC_HASH_KEYS;
+  assert_false(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+}
+
+
+void test_hash_concurrent_remove(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t total;
+  pthread_t threads[ATOMIC_THREADS];
+
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, remove_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  total = 0;
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    total += inserted[i];
+  }
+
+  /* Ensure every key was removed with its data */
+  assert_true(total == ATOMIC_HASH_KEYS);
+  assert_true(ht_atomic_count(&hash_table) == 0);
+
+  /* Insert everything again, deleted entries are reused by their keys */
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, insert_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  total = 0;
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    total += inserted[i];
+  }
+
+  assert_true(total == ATOMIC_HASH_KEYS);
+  assert_true(ht_atomic_count(&hash_table) == ATOMIC_HASH_KEYS);
+}
+
+
+void test_hash_churn(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t total_inserted;
+  uint32_t total_removed;
+  pthread_t threads[ATOMIC_THREADS];
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  memset(churned, 0, sizeof(churned));
+
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, churn_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  total_inserted = 0;
+  total_removed = 0;
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    assert_true(failed[i] == 0);
+    total_inserted += inserted[i];
+    total_removed += removed[i];
+  }
+
+  /* Deleted entries were reused by new keys, none was inserted twice */
+  assert_true(total_inserted == total_removed);
+  assert_true(ht_atomic_count(&hash_table) == ATOMIC_HASH_KEYS);
+
+  for (i = 0; i < ATOMIC_CHURN_KEYS; i++)
+  {
+    assert_true(churned[i]);
+    atomic_key.key = ATOMIC_HASH_KEYS * 4 + i;
+    assert_false(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data));
+  }
+}
+
+
+void test_hash_accumulate(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  pthread_t threads[ATOMIC_THREADS];
+  atomic_key_t atomic_key;
+  uint64_t atomic_data;
+
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, accumulate_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    assert_true(inserted[i] == ATOMIC_HASH_KEYS);
+  }
+
+  /* No increment was lost, existing keys kept their data */
+  for (i = ATOMIC_HASH_KEYS / 2; i < ATOMIC_HASH_KEYS * 3 / 2; i++)
+  {
+    atomic_key.key = i;
+    assert_true(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+        (uint8_t *)&atomic_data));
+    if (i < ATOMIC_HASH_KEYS) {
+      assert_true(atomic_data == (uint64_t)i * 3 + ATOMIC_THREADS);
+    } else {
+      assert_true(atomic_data == ATOMIC_THREADS);
+    }
+  }
+
+  atomic_key.key = ATOMIC_HASH_KEYS * 2;
+  assert_true(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(atomic_data == ATOMIC_THREADS);
+
+  /* The minimum only replaces larger values */
+  assert_true(ht_atomic_accumulate(&hash_table, (uint8_t *)&atomic_key, 2,
+      HT_ATOMIC_MIN));
+  assert_true(ht_atomic_accumulate(&hash_table, (uint8_t *)&atomic_key, 3,
+      HT_ATOMIC_MIN));
+  assert_true(ht_atomic_get(&hash_table, (uint8_t *)&atomic_key,
+      (uint8_t *)&atomic_data));
+  assert_true(atomic_data == 2);
+  assert_true(ht_atomic_count(&hash_table) ==
+      ATOMIC_HASH_KEYS * 3 / 2 + 1);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t total;
+  pthread_t threads[ATOMIC_THREADS];
+
+  memset(&hash_table, 0, sizeof(hash_table));
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+
+  /* Initialize hash_table */
+  assert_true(ht_atomic_init(&hash_table, atomic_hash_function,
+      ATOMIC_HASH_ENTRIES_SIZE, sizeof(uint64_t), sizeof(atomic_key_t),
+      (uint8_t *)hash_table_data));
+
+  /* Populate hash_table from all threads at once */
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, insert_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  total = 0;
+  for (i = 0; i < ATOMIC_THREADS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    total += inserted[i];
+  }
+
+  /* Ensure every key was inserted exactly once */
+  assert_true(total == ATOMIC_HASH_KEYS);
+  assert_true(ht_atomic_count(&hash_table) == ATOMIC_HASH_KEYS);
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_hash,                   setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_concurrent_remove, setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_churn,             setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_accumulate,        setup,
+        teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
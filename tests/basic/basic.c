@@ -29,6 +29,7 @@
 #include <cmocka.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "ht.h"
 #include "ht_iter.h"
@@ -43,10 +44,24 @@ typedef struct {
 } basic_data_t;
 
 #define BASIC_HASH_ENTRIES_SIZE    10
+#define BASIC_THREADS              4
+#define BASIC_READS                200000
 
 static ht_t hash_table;
 static uint8_t hash_table_data[((sizeof(ht_entry_t) +sizeof(basic_key_t) +
     sizeof(basic_data_t)) * BASIC_HASH_ENTRIES_SIZE)];
+static uint32_t hash_table_expiry[BASIC_HASH_ENTRIES_SIZE];
+static uint64_t hash_table_bloom[HT_BLOOM_WORDS(2)];
+static uint32_t basic_clock;
+static uint32_t basic_errors[BASIC_THREADS];
+static uint32_t basic_found[BASIC_THREADS];
+static uint32_t basic_stop;
+
+static uint32_t basic_clock_function(void)
+{
+  return (basic_clock);
+}
+
 
 static uint32_t basic_hash_function(uint8_t *key)
 {
@@ -58,6 +73,140 @@ static uint32_t basic_hash_function(uint8_t *key)
 }
 
 
+static uint32_t basic_seeded_hash_function(uint8_t *key, uint64_t seed)
+{
+  uint32_t hash;
+  basic_key_t *basic_key;
+
+  basic_key = (basic_key_t *)key;
+
+  /* Seed 0 makes every key collide, like keys crafted against one seed */
+  if (!seed) {
+    return (0);
+  }
+
+  hash = basic_key->key ^ (uint32_t)seed ^ (uint32_t)(seed >> 32);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+
+  return (hash);
+}
+
+
+static uint64_t basic_seed_function(void)
+{
+  return (0x9e3779b97f4a7c15ull);
+}
+
+
+static uint64_t basic_zero_seed_function(void)
+{
+  return (0);
+}
+
+
+static void *optimistic_write_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t round;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  (void)arg;
+
+  /* Remove every item and insert it again with the data of a new round */
+  for (round = 1; !__atomic_load_n(&basic_stop, __ATOMIC_ACQUIRE); round++)
+  {
+    for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+    {
+      basic_key.key = i;
+      basic_data.x = round;
+      basic_data.y = i ^ (round * 2654435761u);
+      ht_remove(&hash_table, (uint8_t *)&basic_key, NULL);
+      ht_insert(&hash_table, (uint8_t *)&basic_key, (uint8_t *)&basic_data);
+    }
+  }
+
+  return (NULL);
+}
+
+
+static void *optimistic_churn_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  basic_errors[thread] = 0;
+  basic_found[thread] = 0;
+
+  /* Items come and go, but the data found was written for that key */
+  for (i = 0; i < BASIC_READS; i++)
+  {
+    basic_key.key = i % BASIC_HASH_ENTRIES_SIZE + 1;
+    if (!ht_get_optimistic(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data)) {
+      continue;
+    }
+
+    basic_found[thread]++;
+    if ((basic_data.x != basic_key.key ||
+         basic_data.y != BASIC_HASH_ENTRIES_SIZE - basic_key.key) &&
+        basic_data.y != (basic_key.key ^ (basic_data.x * 2654435761u))) {
+      basic_errors[thread]++;
+    }
+  }
+
+  return (NULL);
+}
+
+
+static void *optimistic_reseed_thread(void *arg)
+{
+  uint64_t seed;
+
+  (void)arg;
+
+  /* Move every item to a new entry again and again */
+  for (seed = 1; !__atomic_load_n(&basic_stop, __ATOMIC_ACQUIRE); seed++)
+  {
+    ht_reseed(&hash_table, seed);
+  }
+
+  return (NULL);
+}
+
+
+static void *optimistic_read_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  basic_errors[thread] = 0;
+
+  /* Every key is always present and keeps the data it was inserted with */
+  for (i = 0; i < BASIC_READS; i++)
+  {
+    basic_key.key = i % BASIC_HASH_ENTRIES_SIZE + 1;
+    if (!ht_get_optimistic(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data) || basic_data.x != basic_key.key ||
+        basic_data.y != BASIC_HASH_ENTRIES_SIZE - basic_key.key) {
+      basic_errors[thread]++;
+    }
+  }
+
+  return (NULL);
+}
+
+
 void test_hash(void **state)
 {
   (void)state;
@@ -98,6 +247,9 @@ void test_hash(void **state)
   assert_true(basic_data.x == 4);
   assert_true(basic_data.y == 6);
 
+  /* Only check that it exists */
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+
   /* Remove same item from hash_table */
   basic_key.key = 4;
   assert_true(ht_remove(&hash_table,
@@ -109,6 +261,247 @@ void test_hash(void **state)
   assert_false(ht_get(&hash_table,
       (uint8_t *)&basic_key,
       (uint8_t *)&basic_data));
+  assert_false(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+}
+
+
+void test_hash_optimistic(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  /* Every populated item is visible to the optimistic reader */
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_get_optimistic(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_true(basic_data.x == i);
+    assert_true(basic_data.y == BASIC_HASH_ENTRIES_SIZE - i);
+  }
+
+  /* Remove one item and check the writer left the sequence even */
+  basic_key.key = 3;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  assert_true((hash_table.sequence & 1) == 0);
+
+  /* Try to get it again */
+  assert_false(ht_get_optimistic(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+}
+
+
+static uint8_t foreach_callback(uint8_t *key, uint8_t *data, void *context)
+{
+  basic_key_t *basic_key;
+  basic_data_t *basic_data;
+
+  basic_key = (basic_key_t *)key;
+  basic_data = (basic_data_t *)data;
+  (*(uint32_t *)context)++;
+
+  /* Remove even keys and update odd ones in place */
+  if (basic_key->key % 2 == 0) {
+    return (HT_FOREACH_DELETE);
+  }
+
+  basic_data->y += 100;
+  return (HT_FOREACH_UPDATE);
+}
+
+
+void test_hash_optimistic_concurrent(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  pthread_t writer;
+  pthread_t readers[BASIC_THREADS];
+
+  /* Readers retry while the writer is in the middle of a change */
+  basic_stop = 0;
+  assert_true(pthread_create(&writer, NULL, optimistic_write_thread,
+      NULL) == 0);
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&readers[i], NULL, optimistic_churn_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    pthread_join(readers[i], NULL);
+  }
+  __atomic_store_n(&basic_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(writer, NULL);
+
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    assert_true(basic_errors[i] == 0);
+    assert_true(basic_found[i] > 0);
+  }
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+  assert_true((hash_table.sequence & 1) == 0);
+}
+
+
+void test_hash_foreach(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t visited;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  visited = 0;
+  assert_true(ht_foreach(&hash_table, foreach_callback, &visited));
+  assert_true(visited == BASIC_HASH_ENTRIES_SIZE);
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE / 2);
+
+  /* Items after a removed one in the same cluster are still reachable */
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    if (i % 2 == 0) {
+      assert_false(ht_get(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data));
+    } else {
+      assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data));
+      assert_true(basic_data.x == i);
+      assert_true(basic_data.y == BASIC_HASH_ENTRIES_SIZE - i + 100);
+    }
+  }
+
+  /* Removed entries are reused */
+  for (i = 2; i <= BASIC_HASH_ENTRIES_SIZE; i += 2)
+  {
+    basic_key.key = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+  }
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+  assert_true(hash_table.tombstones == 0);
+}
+
+
+void test_hash_clear(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t round;
+  ht_iter_t ht_iterator;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  /* Go through enough generations for the counter to wrap around */
+  for (round = 0; round < (2 << HT_GENERATION_BITS); round++)
+  {
+    assert_true(ht_clear(&hash_table));
+    assert_true(ht_count(&hash_table) == 0);
+
+    /* Nothing from the previous generation is visible */
+    basic_key.key = round % BASIC_HASH_ENTRIES_SIZE + 1;
+    assert_false(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+
+    ht_iter_init(&ht_iterator, &hash_table);
+    assert_false(ht_iter_get_next(&ht_iterator, &hash_table,
+        (uint8_t *)&basic_key, (uint8_t *)&basic_data));
+
+    /* Fill it again with data specific to this round */
+    for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+    {
+      basic_key.key = i;
+      basic_data.x = round;
+      basic_data.y = i;
+      assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data));
+    }
+
+    basic_key.key = BASIC_HASH_ENTRIES_SIZE;
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_true(basic_data.x == round);
+  }
+
+  /* Items never written over do not come back when the generation wraps */
+  for (round = 0; round < (2 << HT_GENERATION_BITS); round++)
+  {
+    assert_true(ht_clear(&hash_table));
+    for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+    {
+      basic_key.key = i;
+      assert_false(ht_get(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data));
+    }
+  }
+}
+
+
+void test_hash_ttl(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  basic_clock = 0xFFFFFFF0;
+  assert_true(ht_set_expiry(&hash_table, hash_table_expiry,
+      basic_clock_function));
+
+  /* Replace key 2 by one that expires, across the clock wrap around */
+  basic_key.key = 2;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_data.x = 2;
+  assert_true(ht_insert_ttl(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, 0x20));
+
+  basic_clock += 0x1F;
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+
+  /* Once expired it is missing but still counted */
+  basic_clock++;
+  assert_false(ht_get(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+
+  /* The table is full, the expired entry is reclaimed in place */
+  basic_key.key = 20;
+  assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+
+  /* Items inserted before the expiry times were attached never expire */
+  basic_clock += 0x80000000;
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data) == (i != 2));
+  }
+
+  /* Sweep expired items a few entries at a time */
+  for (i = 3; i <= 6; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+    assert_true(ht_insert_ttl(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data, 10));
+  }
+
+  basic_clock += 10;
+  assert_true(ht_expire(&hash_table, BASIC_HASH_ENTRIES_SIZE / 2) +
+      ht_expire(&hash_table, BASIC_HASH_ENTRIES_SIZE / 2) == 4);
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE - 4);
+  assert_true(ht_expire(&hash_table, BASIC_HASH_ENTRIES_SIZE) == 0);
 }
 
 
@@ -142,6 +535,420 @@ void test_hash_iterator(void **state)
 }
 
 
+static void accumulate_combine(uint8_t *data, uint8_t *delta,
+    uint32_t data_size)
+{
+  basic_data_t *basic_data;
+  basic_data_t *basic_delta;
+
+  assert_true(data_size == sizeof(basic_data_t));
+
+  basic_data = (basic_data_t *)data;
+  basic_delta = (basic_data_t *)delta;
+  basic_data->x += basic_delta->x;
+  basic_data->y += basic_delta->y;
+}
+
+
+void test_hash_accumulate(void **state)
+{
+  (void)state;
+
+  uint8_t value8;
+  uint16_t value16;
+  uint64_t value64;
+  uint8_t delta8;
+  uint16_t delta16;
+  uint64_t delta64;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  /* Combine into an existing item in place */
+  basic_key.key = 3;
+  basic_data.x = 10;
+  basic_data.y = 20;
+  assert_true(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, accumulate_combine));
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+  assert_true(basic_data.x == 13);
+  assert_true(basic_data.y == BASIC_HASH_ENTRIES_SIZE - 3 + 20);
+
+  /* A missing item is inserted with the delta */
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_data.x = 10;
+  basic_data.y = 20;
+  assert_true(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, accumulate_combine));
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+  assert_true(basic_data.x == 10);
+  assert_true(basic_data.y == 20);
+
+  /* No room for a new item in a full hash_table */
+  basic_key.key = BASIC_HASH_ENTRIES_SIZE + 1;
+  assert_false(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, accumulate_combine));
+
+  /* Built-in combine callbacks */
+  value8 = 250;
+  delta8 = 10;
+  ht_combine_add(&value8, &delta8, sizeof(value8));
+  assert_true(value8 == 4);
+
+  value16 = 1000;
+  delta16 = 2000;
+  ht_combine_min((uint8_t *)&value16, (uint8_t *)&delta16, sizeof(value16));
+  assert_true(value16 == 1000);
+  ht_combine_max((uint8_t *)&value16, (uint8_t *)&delta16, sizeof(value16));
+  assert_true(value16 == 2000);
+
+  value64 = 1ull << 40;
+  delta64 = 1;
+  ht_combine_add((uint8_t *)&value64, (uint8_t *)&delta64, sizeof(value64));
+  assert_true(value64 == (1ull << 40) + 1);
+  ht_combine_min((uint8_t *)&value64, (uint8_t *)&delta64, sizeof(value64));
+  assert_true(value64 == 1);
+
+  /* Built-in combine callbacks reject data that is not an integer */
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+  assert_true(ht_init(&hash_table, basic_hash_function,
+      BASIC_HASH_ENTRIES_SIZE, 3, sizeof(basic_key_t), hash_table_data));
+  basic_key.key = 1;
+  assert_false(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, ht_combine_add));
+  assert_false(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, ht_combine_min));
+  assert_false(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, ht_combine_max));
+  assert_true(ht_count(&hash_table) == 0);
+  assert_true(ht_accumulate(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, accumulate_combine));
+  assert_true(ht_count(&hash_table) == 1);
+}
+
+
+void test_hash_bloom(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t false_positives;
+  ht_bloom_t bloom;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  assert_false(ht_rebuild_bloom(&hash_table));
+  assert_true(ht_bloom_init(&bloom, 2, hash_table_bloom));
+  assert_true(ht_set_bloom(&hash_table, &bloom));
+
+  /* Keys already stored were added */
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_bloom_contains(&bloom,
+        basic_hash_function((uint8_t *)&basic_key)));
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_true(basic_data.x == i);
+  }
+
+  /* Missing keys are rejected by the filter most of the time */
+  false_positives = 0;
+  for (i = 1000; i < 2000; i++)
+  {
+    basic_key.key = i;
+    false_positives += ht_bloom_contains(&bloom,
+        basic_hash_function((uint8_t *)&basic_key));
+    assert_false(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_false(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  }
+  assert_true(false_positives < 100);
+
+  /*
+   * Removed keys stay in the filter until it is rebuilt. Keys 1 to 7 share
+   * the same hash.
+   */
+  for (i = 1; i <= 7; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+    assert_true(ht_bloom_contains(&bloom,
+        basic_hash_function((uint8_t *)&basic_key)));
+  }
+
+  assert_true(ht_rebuild_bloom(&hash_table));
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_bloom_contains(&bloom,
+        basic_hash_function((uint8_t *)&basic_key)) == (i > 7));
+  }
+
+  /* Inserted keys are added */
+  basic_key.key = 20;
+  assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+
+  /* Clearing the hash_table clears the filter */
+  assert_true(ht_clear(&hash_table));
+  assert_false(ht_bloom_contains(&bloom,
+      basic_hash_function((uint8_t *)&basic_key)));
+  assert_true(ht_set_bloom(&hash_table, NULL));
+}
+
+
+void test_hash_max_probe(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  /* Key 10 hashes to entry 1 and is stored in entry 9 */
+  assert_true(hash_table.max_probe == 8);
+
+  /* Removing an item keeps the bound, items after it are still found */
+  basic_key.key = 9;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_key.key = 10;
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+  assert_true(hash_table.max_probe == 8);
+
+  /* Clearing the hash_table resets the bound */
+  assert_true(ht_clear(&hash_table));
+  assert_true(hash_table.max_probe == 0);
+
+  /* Invalid load limits are refused */
+  assert_false(ht_set_max_load(&hash_table, 0));
+  assert_false(ht_set_max_load(&hash_table, 101));
+
+  /* Only half of the entries can be used */
+  assert_true(ht_set_max_load(&hash_table, 50));
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE / 2; i++)
+  {
+    basic_key.key = i;
+    basic_data.x = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+  }
+  assert_true(hash_table.max_probe == 4);
+
+  basic_key.key = i;
+  assert_false(ht_insert(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+
+  /* Stored items are found, the refused one is not */
+  basic_key.key = 1;
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_key.key = i;
+  assert_false(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+
+  /* Removing an item makes room for a new one */
+  basic_key.key = 1;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_key.key = i;
+  assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data));
+}
+
+
+void test_hash_seed(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  assert_false(ht_reseed(&hash_table, 1));
+  assert_false(ht_set_seed(&hash_table, NULL, 1, NULL, 0));
+  assert_false(ht_set_seed(&hash_table, basic_seeded_hash_function, 1,
+      basic_seed_function, 0));
+
+  /* Rehashing in place keeps every item and drops the tombstones */
+  assert_true(ht_set_expiry(&hash_table, hash_table_expiry,
+      basic_clock_function));
+  basic_clock = 0;
+  basic_key.key = 3;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_data.x = 3;
+  basic_data.y = 7;
+  assert_true(ht_insert_ttl(&hash_table, (uint8_t *)&basic_key,
+      (uint8_t *)&basic_data, 10));
+  basic_key.key = 9;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+  assert_true(hash_table.tombstones == 1);
+
+  assert_true(ht_set_seed(&hash_table, basic_seeded_hash_function, 1, NULL,
+      0));
+  assert_true(hash_table.seed == 1);
+  assert_true(hash_table.tombstones == 0);
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE - 1);
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data) == (i != 9));
+    if (i != 9) {
+      assert_true(basic_data.x == i);
+    }
+  }
+
+  /* The expiry time moved with its item */
+  basic_clock = 10;
+  basic_key.key = 3;
+  assert_false(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+  basic_key.key = 4;
+  assert_true(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+
+  /* Colliding keys make an insert reseed */
+  assert_true(ht_clear(&hash_table));
+  assert_true(ht_set_seed(&hash_table, basic_seeded_hash_function, 0,
+      basic_seed_function, 2));
+  for (i = 1; i <= 4; i++)
+  {
+    basic_key.key = i;
+    basic_data.x = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+  }
+  assert_true(hash_table.reseeds == 1);
+  assert_true(hash_table.seed == basic_seed_function());
+  for (i = 1; i <= 4; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_true(basic_data.x == i);
+  }
+
+  /* Keys colliding under any seed double the bound, 3 more reseeds */
+  assert_true(ht_clear(&hash_table));
+  assert_true(ht_set_seed(&hash_table, basic_seeded_hash_function, 0,
+      basic_zero_seed_function, 2));
+  for (i = 1; i <= BASIC_HASH_ENTRIES_SIZE; i++)
+  {
+    basic_key.key = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+  }
+  assert_true(hash_table.reseeds == 1 + 3);
+  assert_true(hash_table.reseed_probe == 16);
+  assert_true(hash_table.max_probe == BASIC_HASH_ENTRIES_SIZE - 1);
+}
+
+
+void test_hash_seed_optimistic(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  pthread_t writer;
+  pthread_t readers[BASIC_THREADS];
+
+  assert_true(ht_set_seed(&hash_table, basic_seeded_hash_function, 1, NULL,
+      0));
+
+  /* Readers must hash with the seed of the snapshot they probe */
+  basic_stop = 0;
+  assert_true(pthread_create(&writer, NULL, optimistic_reseed_thread,
+      NULL) == 0);
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    assert_true(pthread_create(&readers[i], NULL, optimistic_read_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    pthread_join(readers[i], NULL);
+  }
+  __atomic_store_n(&basic_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(writer, NULL);
+
+  for (i = 0; i < BASIC_THREADS; i++)
+  {
+    assert_true(basic_errors[i] == 0);
+  }
+  assert_true(ht_count(&hash_table) == BASIC_HASH_ENTRIES_SIZE);
+}
+
+
+void test_hash_probe(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t probe;
+  basic_key_t basic_key;
+  basic_data_t basic_data;
+
+  /* The other probe sequences need a power of two size */
+  assert_false(ht_init_probe(&hash_table, basic_hash_function,
+      BASIC_HASH_ENTRIES_SIZE, sizeof(basic_data_t), sizeof(basic_key_t),
+      hash_table_data, HT_PROBE_TRIANGULAR));
+  assert_false(ht_init_probe(&hash_table, basic_hash_function,
+      BASIC_HASH_ENTRIES_SIZE, sizeof(basic_data_t), sizeof(basic_key_t),
+      hash_table_data, HT_PROBE_DOUBLE));
+  assert_false(ht_init_probe(&hash_table, basic_hash_function, 8,
+      sizeof(basic_data_t), sizeof(basic_key_t), hash_table_data,
+      HT_PROBE_DOUBLE + 1));
+  assert_true(ht_init_probe(&hash_table, basic_hash_function,
+      BASIC_HASH_ENTRIES_SIZE, sizeof(basic_data_t), sizeof(basic_key_t),
+      hash_table_data, HT_PROBE_LINEAR));
+
+  for (probe = HT_PROBE_TRIANGULAR; probe <= HT_PROBE_DOUBLE; probe++)
+  {
+    memset(hash_table_data, 0, sizeof(hash_table_data));
+    assert_true(ht_init_probe(&hash_table, basic_hash_function, 8,
+        sizeof(basic_data_t), sizeof(basic_key_t), hash_table_data, probe));
+
+    /* Keys 0 to 7 hash to entry 0, the sequence visits every entry */
+    for (i = 0; i < 8; i++)
+    {
+      basic_key.key = i;
+      basic_data.x = i;
+      assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data));
+    }
+    assert_true(ht_count(&hash_table) == 8);
+    assert_true(hash_table.max_probe == 7);
+
+    basic_key.key = 8;
+    assert_false(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+
+    /* Removing an item always leaves a tombstone */
+    basic_key.key = 3;
+    assert_true(ht_remove(&hash_table, (uint8_t *)&basic_key, NULL));
+    assert_true(hash_table.tombstones == 1);
+
+    for (i = 0; i < 8; i++)
+    {
+      basic_key.key = i;
+      memset(&basic_data, 0, sizeof(basic_data));
+      assert_true(ht_get(&hash_table, (uint8_t *)&basic_key,
+          (uint8_t *)&basic_data) == (i != 3));
+      assert_true(basic_data.x == (i != 3 ? i : 0));
+    }
+
+    /* Inserting the item again reuses the tombstone */
+    basic_key.key = 3;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&basic_key,
+        (uint8_t *)&basic_data));
+    assert_true(hash_table.tombstones == 0);
+    assert_true(ht_get(&hash_table, (uint8_t *)&basic_key, NULL));
+  }
+}
+
+
 int setup(void **state)
 {
   (void)state;
@@ -208,9 +1015,31 @@ int main(void)
 {
   const struct CMUnitTest tests[] =
   {
-    cmocka_unit_test_setup_teardown(test_hash,          setup,
+    cmocka_unit_test_setup_teardown(test_hash,            setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_optimistic, setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_optimistic_concurrent, setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_foreach,    setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_clear,      setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_ttl,        setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_iterator,   setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_accumulate, setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_bloom,      setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_max_probe,  setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_seed,       setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_probe,      setup,
         teardown),
-    cmocka_unit_test_setup_teardown(test_hash_iterator, setup,
+    cmocka_unit_test_setup_teardown(test_hash_seed_optimistic, setup,
         teardown),
   };
 
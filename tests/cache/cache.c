@@ -0,0 +1,350 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht.h"
+
+typedef struct {
+  uint32_t key;
+} cache_key_t;
+
+typedef struct {
+  uint32_t x;
+} cache_data_t;
+
+#define CACHE_HASH_ENTRIES_SIZE    32
+#define CACHE_CAPACITY             16
+#define CACHE_SKETCH_WIDTH         256
+
+static ht_t hash_table;
+static uint8_t hash_table_data[(sizeof(ht_entry_t) + sizeof(cache_key_t) +
+    sizeof(cache_data_t)) * CACHE_HASH_ENTRIES_SIZE];
+static uint8_t evicted[256];
+static ht_sketch_t sketch;
+static uint8_t sketch_counters[HT_SKETCH_SIZE(CACHE_SKETCH_WIDTH)];
+static uint32_t evicted_count;
+
+static uint32_t cache_hash_function(uint8_t *key)
+{
+  cache_key_t *cache_key;
+
+  cache_key = (cache_key_t *)key;
+
+  return (cache_key->key * 2654435761u);
+}
+
+
+static void cache_evict_function(uint8_t *key, uint8_t *data, void *context)
+{
+  cache_key_t *cache_key;
+  cache_data_t *cache_data;
+
+  cache_key = (cache_key_t *)key;
+  cache_data = (cache_data_t *)data;
+
+  assert_true(context == &hash_table);
+  assert_true(cache_key->key == cache_data->x);
+
+  evicted[cache_key->key] = 1;
+  evicted_count++;
+}
+
+
+void test_hash_evict(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  cache_key_t cache_key;
+  cache_data_t cache_data;
+
+  /* Read the first half of the items so they get a second chance */
+  for (i = 0; i < CACHE_CAPACITY / 2; i++)
+  {
+    cache_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+
+  /* Inserting past the capacity evicts the items that were not read */
+  for (i = CACHE_CAPACITY; i < CACHE_CAPACITY + CACHE_CAPACITY / 2; i++)
+  {
+    cache_key.key = i;
+    cache_data.x = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+    assert_true(ht_count(&hash_table) == CACHE_CAPACITY);
+  }
+
+  /* The items that were read survive the first sweep of the hand */
+  assert_true(evicted_count == CACHE_CAPACITY / 2);
+  for (i = 0; i < CACHE_CAPACITY / 2; i++)
+  {
+    cache_key.key = i;
+    assert_false(evicted[i]);
+    assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+
+  for (i = 0; i < CACHE_CAPACITY + CACHE_CAPACITY / 2; i++)
+  {
+    cache_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data) == !evicted[i]);
+  }
+
+  /* Inserting an existing key evicts nothing */
+  cache_key.key = 0;
+  assert_false(ht_insert(&hash_table, (uint8_t *)&cache_key,
+      (uint8_t *)&cache_data));
+  assert_true(evicted_count == CACHE_CAPACITY / 2);
+}
+
+
+void test_hash_peek(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  ht_entry_t *hash_entry;
+  cache_key_t cache_key;
+  cache_data_t cache_data;
+
+  /* Read the first half of the items, only peek at the second half */
+  for (i = 0; i < CACHE_CAPACITY; i++)
+  {
+    cache_key.key = i;
+    cache_data.x = 0;
+    if (i < CACHE_CAPACITY / 2) {
+      assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+          (uint8_t *)&cache_data));
+    } else {
+      assert_true(ht_peek(&hash_table, (uint8_t *)&cache_key,
+          (uint8_t *)&cache_data));
+    }
+    assert_true(cache_data.x == i);
+  }
+
+  cache_key.key = CACHE_CAPACITY;
+  assert_false(ht_peek(&hash_table, (uint8_t *)&cache_key, NULL));
+
+  /* Peeking gave no second chance, only the read items have one */
+  for (i = 0; i < CACHE_HASH_ENTRIES_SIZE; i++)
+  {
+    hash_entry = ht_entry_get(&hash_table, i);
+    if (ht_entry_used(&hash_table, hash_entry)) {
+      memcpy(&cache_key, (uint8_t *)(hash_entry + sizeof(ht_entry_t)),
+          sizeof(cache_key));
+      assert_true(hash_entry->referenced == (cache_key.key <
+          CACHE_CAPACITY / 2));
+    }
+  }
+}
+
+
+void test_hash_evict_full(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  cache_key_t cache_key;
+  cache_data_t cache_data;
+
+  /* Use every entry, an insert in a full table still evicts one item */
+  assert_true(ht_set_cache(&hash_table, 0, cache_evict_function,
+      &hash_table));
+
+  for (i = CACHE_CAPACITY; i < CACHE_CAPACITY * 4; i++)
+  {
+    cache_key.key = i;
+    cache_data.x = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+
+  assert_true(ht_count(&hash_table) == CACHE_HASH_ENTRIES_SIZE);
+  assert_true(evicted_count == CACHE_CAPACITY * 4 - CACHE_HASH_ENTRIES_SIZE);
+
+  /* The most recent items are all there */
+  for (i = CACHE_CAPACITY * 3; i < CACHE_CAPACITY * 4; i++)
+  {
+    cache_key.key = i;
+    assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+    assert_true(cache_data.x == i);
+  }
+}
+
+
+void test_hash_admission(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t j;
+  cache_key_t cache_key;
+  cache_data_t cache_data;
+
+  assert_true(ht_sketch_init(&sketch, CACHE_SKETCH_WIDTH, sketch_counters));
+  assert_true(ht_set_admission(&hash_table, &sketch));
+
+  /* Every cached item is used a few times */
+  for (j = 0; j < 4; j++)
+  {
+    for (i = 0; i < CACHE_CAPACITY; i++)
+    {
+      cache_key.key = i;
+      assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+          (uint8_t *)&cache_data));
+    }
+  }
+
+  /* A scan of keys seen once does not get in */
+  for (i = 100; i < 164; i++)
+  {
+    cache_key.key = i;
+    cache_data.x = i;
+    assert_false(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+    assert_false(ht_insert(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+
+  assert_true(evicted_count == 0);
+  assert_true(ht_count(&hash_table) == CACHE_CAPACITY);
+
+  /* A key requested often enough replaces one item */
+  cache_key.key = 200;
+  cache_data.x = 200;
+  for (i = 0; i < 5; i++)
+  {
+    assert_false(ht_get(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+  assert_true(ht_insert(&hash_table, (uint8_t *)&cache_key,
+      (uint8_t *)&cache_data));
+
+  assert_true(evicted_count == 1);
+  assert_true(ht_count(&hash_table) == CACHE_CAPACITY);
+  assert_true(ht_get(&hash_table, (uint8_t *)&cache_key,
+      (uint8_t *)&cache_data));
+  assert_true(cache_data.x == 200);
+
+  /* The counters are halved once enough keys were recorded */
+  assert_true(ht_sketch_estimate(&sketch, cache_hash_function(
+      (uint8_t *)&cache_key)) == 7);
+  for (i = 0; i < CACHE_SKETCH_WIDTH * 10; i++)
+  {
+    ht_sketch_increment(&sketch, 0);
+  }
+  assert_true(ht_sketch_estimate(&sketch, cache_hash_function(
+      (uint8_t *)&cache_key)) == 3);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  cache_key_t cache_key;
+  cache_data_t cache_data;
+
+  memset(&hash_table, 0, sizeof(hash_table));
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+  memset(evicted, 0, sizeof(evicted));
+  evicted_count = 0;
+
+  /* Initialize hash_table */
+  assert_true(ht_init(&hash_table, cache_hash_function,
+      CACHE_HASH_ENTRIES_SIZE, sizeof(cache_data_t), sizeof(cache_key_t),
+      hash_table_data));
+  assert_true(ht_set_cache(&hash_table, CACHE_CAPACITY, cache_evict_function,
+      &hash_table));
+  assert_false(ht_set_cache(&hash_table, CACHE_HASH_ENTRIES_SIZE + 1, NULL,
+      NULL));
+
+  /* Populate hash_table up to its capacity */
+  for (i = 0; i < CACHE_CAPACITY; i++)
+  {
+    cache_key.key = i;
+    cache_data.x = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&cache_key,
+        (uint8_t *)&cache_data));
+  }
+
+  assert_true(evicted_count == 0);
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_hash_evict,      setup, teardown),
+    cmocka_unit_test_setup_teardown(test_hash_peek,       setup, teardown),
+    cmocka_unit_test_setup_teardown(test_hash_evict_full, setup, teardown),
+    cmocka_unit_test_setup_teardown(test_hash_admission,  setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
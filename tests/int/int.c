@@ -0,0 +1,238 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_int.h"
+
+#define INT_HASH_ENTRIES_SIZE    1024
+#define INT_HASH_KEYS            900
+
+static ht_int_t hash_table;
+static ht_int_entry_t hash_table_entries[INT_HASH_ENTRIES_SIZE];
+
+static uint64_t int_key(uint32_t i)
+{
+  /* Spread the keys over 64 bits, key 0 is the empty key */
+  return ((uint64_t)i * 0x9e3779b97f4a7c15ull);
+}
+
+
+void test_int(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint64_t value;
+
+  /* Repeated keys are not allowed, the empty key included */
+  assert_false(ht_int_insert(&hash_table, int_key(1), 0));
+  assert_false(ht_int_insert(&hash_table, HT_INT_EMPTY_KEY, 0));
+
+  assert_true(ht_int_get(&hash_table, HT_INT_EMPTY_KEY, &value));
+  assert_true(value == 0);
+  assert_true(ht_int_get(&hash_table, int_key(10), &value));
+  assert_true(value == 10);
+  assert_false(ht_int_get(&hash_table, int_key(INT_HASH_KEYS), &value));
+
+  /* Remove every other key, the others must still be found */
+  for (i = 0; i < INT_HASH_KEYS; i += 2)
+  {
+    assert_true(ht_int_remove(&hash_table, int_key(i), &value));
+    assert_true(value == i);
+    assert_false(ht_int_remove(&hash_table, int_key(i), NULL));
+  }
+  assert_true(ht_int_count(&hash_table) == INT_HASH_KEYS / 2);
+
+  for (i = 0; i < INT_HASH_KEYS; i++)
+  {
+    assert_true(ht_int_get(&hash_table, int_key(i), NULL) == (i & 1));
+  }
+
+  /* Removal leaves no tombstones, empty entries are back */
+  value = 0;
+  for (i = 0; i < INT_HASH_ENTRIES_SIZE; i++)
+  {
+    value += hash_table_entries[i].key == HT_INT_EMPTY_KEY;
+  }
+  assert_true(value == INT_HASH_ENTRIES_SIZE - INT_HASH_KEYS / 2);
+}
+
+
+void test_int_full(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint64_t value;
+  ht_int_entry_t entries[8];
+
+  assert_false(ht_int_init(&hash_table, 6, entries));
+  assert_true(ht_int_init(&hash_table, 8, entries));
+
+  for (i = 1; i <= 8; i++)
+  {
+    assert_true(ht_int_insert(&hash_table, i, i * 2));
+  }
+  assert_false(ht_int_insert(&hash_table, 9, 18));
+  assert_false(ht_int_get(&hash_table, 9, NULL));
+
+  /* The empty key does not need an entry */
+  assert_true(ht_int_insert(&hash_table, HT_INT_EMPTY_KEY, 7));
+  assert_true(ht_int_count(&hash_table) == 9);
+
+  for (i = 8; i >= 1; i--)
+  {
+    assert_true(ht_int_remove(&hash_table, i, &value));
+    assert_true(value == i * 2);
+    assert_false(ht_int_get(&hash_table, i, NULL));
+  }
+
+  assert_true(ht_int_remove(&hash_table, HT_INT_EMPTY_KEY, &value));
+  assert_true(value == 7);
+  assert_false(ht_int_remove(&hash_table, HT_INT_EMPTY_KEY, &value));
+  assert_true(ht_int_count(&hash_table) == 0);
+}
+
+
+void test_int32(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t value;
+  uint32_t empty;
+  ht_int32_t hash_table32;
+  ht_int32_entry_t entries[INT_HASH_ENTRIES_SIZE];
+
+  /* Keys and values share 8 bytes */
+  assert_true(sizeof(ht_int32_entry_t) == 8);
+  assert_false(ht_int32_init(&hash_table32, 6, entries));
+  assert_true(ht_int32_init(&hash_table32, INT_HASH_ENTRIES_SIZE, entries));
+
+  for (i = 0; i < INT_HASH_KEYS; i++)
+  {
+    assert_true(ht_int32_insert(&hash_table32, (uint32_t)int_key(i), i));
+  }
+  assert_false(ht_int32_insert(&hash_table32, (uint32_t)int_key(1), 0));
+  assert_false(ht_int32_insert(&hash_table32, HT_INT_EMPTY_KEY, 0));
+  assert_true(ht_int32_count(&hash_table32) == INT_HASH_KEYS);
+
+  assert_true(ht_int32_get(&hash_table32, HT_INT_EMPTY_KEY, &value));
+  assert_true(value == 0);
+  assert_true(ht_int32_get(&hash_table32, (uint32_t)int_key(10), &value));
+  assert_true(value == 10);
+
+  /* Remove every other key, the others must still be found */
+  for (i = 0; i < INT_HASH_KEYS; i += 2)
+  {
+    assert_true(ht_int32_remove(&hash_table32, (uint32_t)int_key(i),
+        &value));
+    assert_true(value == i);
+    assert_false(ht_int32_remove(&hash_table32, (uint32_t)int_key(i),
+        NULL));
+  }
+  assert_true(ht_int32_count(&hash_table32) == INT_HASH_KEYS / 2);
+
+  for (i = 0; i < INT_HASH_KEYS; i++)
+  {
+    assert_true(ht_int32_get(&hash_table32, (uint32_t)int_key(i), NULL) ==
+        (i & 1));
+  }
+
+  /* Removal leaves no tombstones, empty entries are back */
+  empty = 0;
+  for (i = 0; i < INT_HASH_ENTRIES_SIZE; i++)
+  {
+    empty += entries[i].key == HT_INT_EMPTY_KEY;
+  }
+  assert_true(empty == INT_HASH_ENTRIES_SIZE - INT_HASH_KEYS / 2);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+
+  assert_true(ht_int_init(&hash_table, INT_HASH_ENTRIES_SIZE,
+      hash_table_entries));
+
+  for (i = 0; i < INT_HASH_KEYS; i++)
+  {
+    assert_true(ht_int_insert(&hash_table, int_key(i), i));
+  }
+  assert_true(ht_int_count(&hash_table) == INT_HASH_KEYS);
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_int,      setup, teardown),
+    cmocka_unit_test_setup_teardown(test_int_full, setup, teardown),
+    cmocka_unit_test_setup_teardown(test_int32,    setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
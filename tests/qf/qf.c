@@ -0,0 +1,284 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_qf.h"
+
+typedef struct {
+  uint32_t key;
+} qf_key_t;
+
+#define QF_QUOTIENT_BITS     8
+#define QF_REMAINDER_BITS    8
+#define QF_KEYS              100
+#define QF_HASH_ENTRIES_SIZE 256
+
+static ht_qf_t qf;
+static uint64_t qf_slots[HT_QF_WORDS(QF_QUOTIENT_BITS, QF_REMAINDER_BITS)];
+static ht_t hash_table;
+static uint8_t hash_table_data[(sizeof(ht_entry_t) + sizeof(qf_key_t)) *
+    QF_HASH_ENTRIES_SIZE];
+static uint32_t scan_last;
+static uint32_t scan_count;
+
+static uint32_t qf_hash_function(uint8_t *key)
+{
+  qf_key_t *qf_key;
+
+  qf_key = (qf_key_t *)key;
+
+  /* The fingerprint is the high 16 bits, keep it predictable */
+  return (qf_key->key << 16);
+}
+
+
+static void scan_callback(uint32_t fingerprint, void *context)
+{
+  (void)context;
+
+  /* Keys were inserted by steps of 3, fingerprints come sorted */
+  assert_true(fingerprint % 3 == 0);
+  if (scan_count) {
+    assert_true(fingerprint > scan_last);
+  }
+
+  scan_last = fingerprint;
+  scan_count++;
+}
+
+
+void test_qf(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  qf_key_t qf_key;
+
+  /* Every key is found, keys in between are not */
+  for (i = 0; i < QF_KEYS * 3; i++)
+  {
+    qf_key.key = i;
+    assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key) == (i % 3 == 0));
+  }
+
+  /* Same fingerprint again stores a copy, removing it leaves the first */
+  qf_key.key = 3;
+  assert_true(ht_qf_insert(&qf, (uint8_t *)&qf_key));
+  assert_true(ht_qf_count(&qf) == QF_KEYS + 1);
+  assert_true(ht_qf_remove(&qf, (uint8_t *)&qf_key));
+  assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key));
+
+  scan_count = 0;
+  ht_qf_foreach(&qf, scan_callback, NULL);
+  assert_true(scan_count == QF_KEYS);
+
+  /* Remove every other key, clusters shift back */
+  for (i = 0; i < QF_KEYS * 3; i += 6)
+  {
+    qf_key.key = i;
+    assert_true(ht_qf_remove(&qf, (uint8_t *)&qf_key));
+    assert_false(ht_qf_remove(&qf, (uint8_t *)&qf_key));
+  }
+  assert_true(ht_qf_count(&qf) == QF_KEYS / 2);
+
+  for (i = 0; i < QF_KEYS * 3; i++)
+  {
+    qf_key.key = i;
+    assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key) == (i % 6 == 3));
+  }
+
+  scan_count = 0;
+  ht_qf_foreach(&qf, scan_callback, NULL);
+  assert_true(scan_count == QF_KEYS / 2);
+}
+
+
+void test_qf_collision(void **state)
+{
+  (void)state;
+
+  qf_key_t qf_key;
+  qf_key_t qf_key_collision;
+
+  /* Both keys hash to the same fingerprint */
+  qf_key.key = 4;
+  qf_key_collision.key = 4 + (1 << 16);
+
+  assert_true(ht_qf_insert(&qf, (uint8_t *)&qf_key));
+  assert_true(ht_qf_insert(&qf, (uint8_t *)&qf_key_collision));
+  assert_true(ht_qf_count(&qf) == QF_KEYS + 2);
+
+  assert_true(ht_qf_remove(&qf, (uint8_t *)&qf_key));
+  assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key_collision));
+
+  assert_true(ht_qf_remove(&qf, (uint8_t *)&qf_key_collision));
+  assert_false(ht_qf_contains(&qf, (uint8_t *)&qf_key_collision));
+  assert_false(ht_qf_remove(&qf, (uint8_t *)&qf_key_collision));
+  assert_true(ht_qf_count(&qf) == QF_KEYS);
+
+  /* The neighbour keys of the cluster are still there */
+  qf_key.key = 3;
+  assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key));
+  qf_key.key = 6;
+  assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key));
+}
+
+
+void test_qf_full(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  qf_key_t qf_key;
+
+  assert_false(ht_qf_init(&qf, qf_hash_function, 0, QF_REMAINDER_BITS,
+      qf_slots));
+  assert_false(ht_qf_init(&qf, qf_hash_function, QF_QUOTIENT_BITS, 25,
+      qf_slots));
+  assert_true(ht_qf_init(&qf, qf_hash_function, QF_QUOTIENT_BITS,
+      QF_REMAINDER_BITS, qf_slots));
+
+  /* Every key lands in the same quotient, the run wraps around */
+  for (i = 0; i < (1 << QF_QUOTIENT_BITS); i++)
+  {
+    qf_key.key = (200 << QF_REMAINDER_BITS) + i;
+    assert_true(ht_qf_insert(&qf, (uint8_t *)&qf_key));
+  }
+
+  qf_key.key = 1;
+  assert_false(ht_qf_insert(&qf, (uint8_t *)&qf_key));
+
+  for (i = 0; i < (1 << QF_QUOTIENT_BITS); i++)
+  {
+    qf_key.key = (200 << QF_REMAINDER_BITS) + i;
+    assert_true(ht_qf_remove(&qf, (uint8_t *)&qf_key));
+  }
+
+  assert_true(ht_qf_count(&qf) == 0);
+  for (i = 0; i < HT_QF_WORDS(QF_QUOTIENT_BITS, QF_REMAINDER_BITS); i++)
+  {
+    assert_true(qf_slots[i] == 0);
+  }
+}
+
+
+void test_qf_build(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  qf_key_t qf_key;
+
+  assert_true(ht_init(&hash_table, qf_hash_function, QF_HASH_ENTRIES_SIZE,
+      0, sizeof(qf_key_t), hash_table_data));
+
+  for (i = 1000; i < 1000 + QF_KEYS; i++)
+  {
+    qf_key.key = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&qf_key, NULL));
+  }
+
+  assert_true(ht_qf_build(&qf, &hash_table));
+  assert_true(ht_qf_count(&qf) == QF_KEYS * 2);
+
+  for (i = 1000; i < 1000 + QF_KEYS; i++)
+  {
+    qf_key.key = i;
+    assert_true(ht_qf_contains(&qf, (uint8_t *)&qf_key));
+  }
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  qf_key_t qf_key;
+
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+
+  assert_true(ht_qf_init(&qf, qf_hash_function, QF_QUOTIENT_BITS,
+      QF_REMAINDER_BITS, qf_slots));
+
+  /* Neighbour keys share quotients and build long clusters */
+  for (i = 0; i < QF_KEYS * 3; i += 3)
+  {
+    qf_key.key = i;
+    assert_true(ht_qf_insert(&qf, (uint8_t *)&qf_key));
+  }
+  assert_true(ht_qf_count(&qf) == QF_KEYS);
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_qf,           setup, teardown),
+    cmocka_unit_test_setup_teardown(test_qf_collision, setup, teardown),
+    cmocka_unit_test_setup_teardown(test_qf_full,      setup, teardown),
+    cmocka_unit_test_setup_teardown(test_qf_build,     setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
@@ -0,0 +1,297 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "ht_rcu.h"
+
+typedef struct {
+  uint32_t key;
+} rcu_key_t;
+
+typedef struct {
+  uint32_t      version;
+  uint32_t      check;
+} rcu_data_t;
+
+#define RCU_HASH_ENTRIES_SIZE    64
+#define RCU_HASH_KEYS            32
+#define RCU_READERS              3
+#define RCU_PUBLISHES            100
+
+#define RCU_ENTRY_SIZE \
+  (sizeof(ht_entry_t) + sizeof(rcu_key_t) + sizeof(rcu_data_t))
+
+static ht_rcu_t rcu;
+static ht_rcu_reader_t readers[RCU_READERS + 1];
+static ht_t tables[2];
+static uint8_t tables_data[2][RCU_ENTRY_SIZE * RCU_HASH_ENTRIES_SIZE];
+static uint32_t errors[RCU_READERS];
+static uint32_t sections[RCU_READERS];
+static uint32_t stop;
+static uint32_t published;
+
+static uint32_t rcu_hash_function(uint8_t *key)
+{
+  rcu_key_t *rcu_key;
+
+  rcu_key = (rcu_key_t *)key;
+
+  return (rcu_key->key * 2654435761u);
+}
+
+
+static void rcu_build(ht_t *hash_table, uint8_t *data, uint32_t version)
+{
+  uint32_t i;
+  rcu_key_t rcu_key;
+  rcu_data_t rcu_data;
+
+  memset(data, 0, sizeof(tables_data[0]));
+  assert_true(ht_init(hash_table, rcu_hash_function, RCU_HASH_ENTRIES_SIZE,
+      sizeof(rcu_data_t), sizeof(rcu_key_t), data));
+
+  /* Every item of a version is checked against its key */
+  for (i = 0; i < RCU_HASH_KEYS; i++)
+  {
+    rcu_key.key = i;
+    rcu_data.version = version;
+    rcu_data.check = i ^ version;
+    assert_true(ht_insert(hash_table, (uint8_t *)&rcu_key,
+        (uint8_t *)&rcu_data));
+  }
+}
+
+
+static void *read_thread(void *arg)
+{
+  uint32_t i;
+  uint32_t thread;
+  uint32_t version;
+  ht_t *hash_table;
+  rcu_key_t rcu_key;
+  rcu_data_t rcu_data;
+
+  thread = (uint32_t)(uintptr_t)arg;
+  errors[thread] = 0;
+
+  while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE))
+  {
+    hash_table = ht_rcu_read_lock(&rcu, thread);
+
+    /* A read section sees every item of one version, never a freed one */
+    version = 0;
+    for (i = 0; i < RCU_HASH_KEYS; i++)
+    {
+      rcu_key.key = i;
+      if (!ht_peek(hash_table, (uint8_t *)&rcu_key, (uint8_t *)&rcu_data) ||
+          rcu_data.check != (i ^ rcu_data.version) ||
+          (i && rcu_data.version != version)) {
+        errors[thread]++;
+      }
+      version = rcu_data.version;
+    }
+
+    ht_rcu_read_unlock(&rcu, thread);
+    __atomic_add_fetch(&sections[thread], 1, __ATOMIC_RELEASE);
+  }
+
+  return (NULL);
+}
+
+
+static void rcu_wait_readers(void)
+{
+  uint32_t i;
+  uint32_t seen[RCU_READERS];
+
+  /* Let every reader run read sections against the published table */
+  for (i = 0; i < RCU_READERS; i++)
+  {
+    seen[i] = __atomic_load_n(&sections[i], __ATOMIC_ACQUIRE);
+  }
+
+  for (i = 0; i < RCU_READERS; i++)
+  {
+    while (__atomic_load_n(&sections[i], __ATOMIC_ACQUIRE) < seen[i] + 2)
+    {
+      sched_yield();
+    }
+  }
+}
+
+
+static void *publish_thread(void *arg)
+{
+  ht_t *previous;
+
+  previous = ht_rcu_publish(&rcu, (ht_t *)arg);
+  __atomic_store_n(&published, 1, __ATOMIC_RELEASE);
+
+  return (previous);
+}
+
+
+void test_rcu(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t version;
+  ht_t *previous;
+  rcu_key_t rcu_key;
+  rcu_data_t rcu_data;
+  pthread_t threads[RCU_READERS];
+
+  stop = 0;
+  memset(sections, 0, sizeof(sections));
+  for (i = 0; i < RCU_READERS; i++)
+  {
+    assert_true(pthread_create(&threads[i], NULL, read_thread,
+        (void *)(uintptr_t)i) == 0);
+  }
+
+  /* Build the next version in the free table, publish it, free the old one */
+  for (version = 2; version < RCU_PUBLISHES + 2; version++)
+  {
+    rcu_wait_readers();
+    rcu_build(&tables[version % 2], tables_data[version % 2], version);
+    previous = ht_rcu_publish(&rcu, &tables[version % 2]);
+    assert_true(previous == &tables[(version + 1) % 2]);
+    memset(tables_data[(version + 1) % 2], 0, sizeof(tables_data[0]));
+  }
+
+  __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < RCU_READERS; i++)
+  {
+    pthread_join(threads[i], NULL);
+    assert_true(errors[i] == 0);
+    assert_true(sections[i] > 0);
+  }
+
+  /* The last version is the published one */
+  for (i = 0; i < RCU_HASH_KEYS; i++)
+  {
+    rcu_key.key = i;
+    assert_true(ht_rcu_get(&rcu, RCU_READERS, (uint8_t *)&rcu_key,
+        (uint8_t *)&rcu_data));
+    assert_true(rcu_data.version == version - 1);
+  }
+}
+
+
+void test_rcu_publish_wait(void **state)
+{
+  (void)state;
+
+  void *previous;
+  pthread_t thread;
+  struct timespec wait = { 0, 50 * 1000 * 1000 };
+
+  rcu_build(&tables[0], tables_data[0], 2);
+
+  /* Publishing waits for a reader that may still hold the old table */
+  assert_true(ht_rcu_read_lock(&rcu, RCU_READERS) == &tables[1]);
+  published = 0;
+  assert_true(pthread_create(&thread, NULL, publish_thread,
+      &tables[0]) == 0);
+  nanosleep(&wait, NULL);
+  assert_false(__atomic_load_n(&published, __ATOMIC_ACQUIRE));
+
+  ht_rcu_read_unlock(&rcu, RCU_READERS);
+  pthread_join(thread, &previous);
+  assert_true(published);
+  assert_true(previous == &tables[1]);
+
+  /* A reader that left its read section does not hold back the next one */
+  assert_true(ht_rcu_read_lock(&rcu, RCU_READERS) == &tables[0]);
+  ht_rcu_read_unlock(&rcu, RCU_READERS);
+  assert_true(ht_rcu_publish(&rcu, &tables[1]) == &tables[0]);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  memset(&rcu, 0, sizeof(rcu));
+  memset(tables, 0, sizeof(tables));
+
+  /* Publish the first version */
+  rcu_build(&tables[1], tables_data[1], 1);
+  assert_true(ht_rcu_init(&rcu, &tables[1], readers, RCU_READERS + 1));
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_rcu,              setup, teardown),
+    cmocka_unit_test_setup_teardown(test_rcu_publish_wait, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
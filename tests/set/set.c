@@ -0,0 +1,196 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_set.h"
+
+typedef struct {
+  uint32_t key;
+} set_key_t;
+
+#define SET_ENTRIES_SIZE    10
+
+static ht_set_t set;
+static uint8_t set_data[HT_SET_SIZE(SET_ENTRIES_SIZE, sizeof(set_key_t))];
+
+static uint32_t set_hash_function(uint8_t *key)
+{
+  set_key_t *set_key;
+
+  set_key = (set_key_t *)key;
+
+  /* Same clustering as the basic test */
+  return ((set_key->key * 32) >> 8);
+}
+
+
+void test_set(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  set_key_t set_key;
+
+  /* Try to add when the set is full */
+  set_key.key = 20;
+  assert_false(ht_set_add(&set, (uint8_t *)&set_key));
+  assert_false(ht_set_contains(&set, (uint8_t *)&set_key));
+
+  for (i = 1; i <= SET_ENTRIES_SIZE; i++)
+  {
+    set_key.key = i;
+    assert_true(ht_set_contains(&set, (uint8_t *)&set_key));
+  }
+
+  /* Remove one key and try to remove it again */
+  set_key.key = 4;
+  assert_true(ht_set_remove(&set, (uint8_t *)&set_key));
+  assert_false(ht_set_remove(&set, (uint8_t *)&set_key));
+  assert_false(ht_set_contains(&set, (uint8_t *)&set_key));
+  assert_true(ht_set_count(&set) == SET_ENTRIES_SIZE - 1);
+
+  /* The keys after it are still found */
+  for (i = 5; i <= SET_ENTRIES_SIZE; i++)
+  {
+    set_key.key = i;
+    assert_true(ht_set_contains(&set, (uint8_t *)&set_key));
+  }
+
+  /* Its entry is reused by a new key */
+  set_key.key = 20;
+  assert_true(ht_set_add(&set, (uint8_t *)&set_key));
+  assert_true(ht_set_contains(&set, (uint8_t *)&set_key));
+  assert_true(ht_set_count(&set) == SET_ENTRIES_SIZE);
+}
+
+
+void test_set_remove_all(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  set_key_t set_key;
+
+  for (i = 1; i <= SET_ENTRIES_SIZE; i++)
+  {
+    set_key.key = i;
+    assert_true(ht_set_remove(&set, (uint8_t *)&set_key));
+  }
+
+  assert_true(ht_set_count(&set) == 0);
+
+  for (i = 1; i <= SET_ENTRIES_SIZE; i++)
+  {
+    set_key.key = i;
+    assert_false(ht_set_contains(&set, (uint8_t *)&set_key));
+  }
+
+  /* The last removal of a cluster also clears the tombstones before it */
+  assert_true(ht_set_init(&set, set_hash_function, SET_ENTRIES_SIZE,
+      sizeof(set_key_t), set_data));
+  set_key.key = 3;
+  assert_true(ht_set_add(&set, (uint8_t *)&set_key));
+  set_key.key = 5;
+  assert_true(ht_set_add(&set, (uint8_t *)&set_key));
+  set_key.key = 3;
+  assert_true(ht_set_remove(&set, (uint8_t *)&set_key));
+  assert_true(set_data[0] != 0);
+  set_key.key = 5;
+  assert_true(ht_set_contains(&set, (uint8_t *)&set_key));
+  assert_true(ht_set_remove(&set, (uint8_t *)&set_key));
+  assert_true(set_data[0] == 0);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  set_key_t set_key;
+
+  assert_false(ht_set_init(&set, set_hash_function, 0, sizeof(set_key_t),
+      set_data));
+  assert_true(ht_set_init(&set, set_hash_function, SET_ENTRIES_SIZE,
+      sizeof(set_key_t), set_data));
+
+  /* Populate the set ensuring that repeated keys are not allowed */
+  for (i = 1; i <= SET_ENTRIES_SIZE; i++)
+  {
+    set_key.key = i;
+    assert_true(ht_set_add(&set, (uint8_t *)&set_key));
+    assert_false(ht_set_add(&set, (uint8_t *)&set_key));
+    assert_true(ht_set_count(&set) == i);
+  }
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_set,            setup, teardown),
+    cmocka_unit_test_setup_teardown(test_set_remove_all, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
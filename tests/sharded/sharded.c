@@ -0,0 +1,311 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_sharded.h"
+
+typedef struct {
+  uint32_t key;
+} sharded_key_t;
+
+typedef struct {
+  uint32_t x;
+} sharded_data_t;
+
+#define SHARDED_HASH_ENTRIES_SIZE    64
+#define SHARDED_SHARDS               4
+#define SHARDED_PRODUCERS            2
+#define SHARDED_QUEUE_SIZE           32
+#define SHARDED_KEYS                 100
+
+static ht_sharded_t sharded;
+static ht_t shards[SHARDED_SHARDS];
+static uint8_t shards_data[SHARDED_SHARDS][(sizeof(ht_entry_t) +
+    sizeof(sharded_key_t) + sizeof(sharded_data_t)) *
+    SHARDED_HASH_ENTRIES_SIZE];
+static ht_spsc_t queues[SHARDED_PRODUCERS * SHARDED_SHARDS];
+static uint32_t cursors[SHARDED_SHARDS];
+static uint8_t queues_data[SHARDED_PRODUCERS * SHARDED_SHARDS][
+  HT_SHARDED_MESSAGE_SIZE(sizeof(sharded_key_t), sizeof(sharded_data_t)) *
+  SHARDED_QUEUE_SIZE];
+
+static uint32_t sharded_hash_function(uint8_t *key)
+{
+  sharded_key_t *sharded_key;
+
+  sharded_key = (sharded_key_t *)key;
+
+  return (sharded_key->key * 2654435761u);
+}
+
+
+void test_hash(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t count;
+  sharded_key_t sharded_key;
+  sharded_data_t sharded_data;
+
+  /* Every shard holds its share of the keys */
+  count = 0;
+  for (i = 0; i < SHARDED_SHARDS; i++)
+  {
+    assert_true(ht_count(&shards[i]) > 0);
+    count += ht_count(&shards[i]);
+  }
+  assert_true(count == SHARDED_KEYS);
+
+  /* Get item and check it lives in the shard it is routed to */
+  sharded_key.key = 42;
+  assert_true(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+      (uint8_t *)&sharded_data));
+  assert_true(sharded_data.x == 42);
+  assert_true(ht_get(&shards[ht_sharded_shard(&sharded,
+      (uint8_t *)&sharded_key)], (uint8_t *)&sharded_key,
+      (uint8_t *)&sharded_data));
+
+  /* Remove it directly and try to get it again */
+  assert_true(ht_sharded_remove(&sharded, (uint8_t *)&sharded_key,
+      (uint8_t *)&sharded_data));
+  assert_false(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+      (uint8_t *)&sharded_data));
+}
+
+
+void test_hash_owner(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t count;
+  uint32_t total;
+  uint32_t failed;
+  sharded_key_t sharded_key;
+  sharded_data_t sharded_data;
+
+  assert_true(ht_sharded_set_queues(&sharded, queues, SHARDED_PRODUCERS,
+      cursors));
+
+  /* Queue removes from one producer and inserts from the other */
+  for (i = 0; i < 10; i++)
+  {
+    sharded_key.key = i;
+    assert_true(ht_sharded_submit(&sharded, 0, HT_SHARDED_REMOVE,
+        (uint8_t *)&sharded_key, NULL));
+
+    sharded_key.key = SHARDED_KEYS + i;
+    sharded_data.x = SHARDED_KEYS + i;
+    assert_true(ht_sharded_submit(&sharded, 1, HT_SHARDED_INSERT,
+        (uint8_t *)&sharded_key, (uint8_t *)&sharded_data));
+  }
+
+  /* Nothing changes until the owners drain their queues */
+  sharded_key.key = 0;
+  assert_true(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+      (uint8_t *)&sharded_data));
+
+  count = 0;
+  for (i = 0; i < SHARDED_SHARDS; i++)
+  {
+    count += ht_sharded_drain(&sharded, i, SHARDED_QUEUE_SIZE, &failed);
+    assert_true(failed == 0);
+  }
+  assert_true(count == 20);
+
+  for (i = 0; i < 10; i++)
+  {
+    sharded_key.key = i;
+    assert_false(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+        (uint8_t *)&sharded_data));
+
+    sharded_key.key = SHARDED_KEYS + i;
+    assert_true(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+        (uint8_t *)&sharded_data));
+    assert_true(sharded_data.x == SHARDED_KEYS + i);
+  }
+
+  /* Refused operations are counted and taken off the queue */
+  sharded_key.key = 0;
+  assert_true(ht_sharded_submit(&sharded, 0, HT_SHARDED_REMOVE,
+      (uint8_t *)&sharded_key, NULL));
+  sharded_key.key = SHARDED_KEYS;
+  assert_true(ht_sharded_submit(&sharded, 1, HT_SHARDED_INSERT,
+      (uint8_t *)&sharded_key, (uint8_t *)&sharded_data));
+
+  count = 0;
+  total = 0;
+  for (i = 0; i < SHARDED_SHARDS; i++)
+  {
+    count += ht_sharded_drain(&sharded, i, SHARDED_QUEUE_SIZE, &failed);
+    total += failed;
+    assert_true(ht_sharded_drain(&sharded, i, SHARDED_QUEUE_SIZE,
+        NULL) == 0);
+  }
+  assert_true(count == 2);
+  assert_true(total == 2);
+}
+
+
+void test_hash_owner_flood(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t shard;
+  uint32_t failed;
+  sharded_key_t sharded_key;
+  sharded_data_t sharded_data;
+
+  assert_true(ht_sharded_set_queues(&sharded, queues, SHARDED_PRODUCERS,
+      cursors));
+
+  /* Producer 0 fills its queue to the shard of the first new key */
+  sharded_key.key = SHARDED_KEYS;
+  shard = ht_sharded_shard(&sharded, (uint8_t *)&sharded_key);
+  for (i = SHARDED_KEYS; i < SHARDED_KEYS * 10; i++)
+  {
+    sharded_key.key = i;
+    sharded_data.x = i;
+    if (ht_sharded_shard(&sharded, (uint8_t *)&sharded_key) == shard &&
+        !ht_sharded_submit(&sharded, 0, HT_SHARDED_INSERT,
+        (uint8_t *)&sharded_key, (uint8_t *)&sharded_data)) {
+      break;
+    }
+  }
+  assert_true(i < SHARDED_KEYS * 10);
+
+  /* Producer 1 gets its turn even if the shard drains one at a time */
+  sharded_key.key = SHARDED_KEYS * 10;
+  for (i = 0; i < 2; i++)
+  {
+    do {
+      sharded_key.key++;
+    } while (ht_sharded_shard(&sharded, (uint8_t *)&sharded_key) != shard);
+
+    sharded_data.x = sharded_key.key;
+    assert_true(ht_sharded_submit(&sharded, 1, HT_SHARDED_INSERT,
+        (uint8_t *)&sharded_key, (uint8_t *)&sharded_data));
+
+    assert_true(ht_sharded_drain(&sharded, shard, 1, &failed) == 1);
+    assert_true(ht_sharded_drain(&sharded, shard, 1, &failed) == 1);
+    assert_true(failed == 0);
+    assert_true(ht_sharded_get(&sharded, (uint8_t *)&sharded_key,
+        (uint8_t *)&sharded_data));
+    assert_true(sharded_data.x == sharded_key.key);
+  }
+
+  /* The flood is still queued */
+  assert_true(ht_sharded_drain(&sharded, shard, 2, &failed) == 2);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  sharded_key_t sharded_key;
+  sharded_data_t sharded_data;
+
+  memset(shards_data, 0, sizeof(shards_data));
+
+  /* Initialize shards and queues */
+  for (i = 0; i < SHARDED_SHARDS; i++)
+  {
+    assert_true(ht_init(&shards[i], sharded_hash_function,
+        SHARDED_HASH_ENTRIES_SIZE, sizeof(sharded_data_t),
+        sizeof(sharded_key_t), shards_data[i]));
+  }
+
+  for (i = 0; i < SHARDED_PRODUCERS * SHARDED_SHARDS; i++)
+  {
+    assert_true(ht_spsc_init(&queues[i], queues_data[i], SHARDED_QUEUE_SIZE,
+        HT_SHARDED_MESSAGE_SIZE(sizeof(sharded_key_t),
+        sizeof(sharded_data_t))));
+  }
+
+  assert_true(ht_sharded_init(&sharded, shards, SHARDED_SHARDS));
+
+  /* Populate the shards */
+  for (i = 0; i < SHARDED_KEYS; i++)
+  {
+    sharded_key.key = i;
+    sharded_data.x = i;
+    assert_true(ht_sharded_insert(&sharded, (uint8_t *)&sharded_key,
+        (uint8_t *)&sharded_data));
+  }
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_hash,             setup, teardown),
+    cmocka_unit_test_setup_teardown(test_hash_owner,       setup, teardown),
+    cmocka_unit_test_setup_teardown(test_hash_owner_flood, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
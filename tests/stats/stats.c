@@ -0,0 +1,327 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_stats.h"
+#include "ht_counters.h"
+
+typedef struct {
+  uint32_t key;
+} stats_key_t;
+
+typedef struct {
+  uint32_t value;
+} stats_data_t;
+
+#define STATS_ENTRIES_SIZE    16
+
+#define STATS_ENTRY_SIZE \
+  (sizeof(ht_entry_t) + sizeof(stats_key_t) + sizeof(stats_data_t))
+
+static ht_t hash_table;
+static uint8_t hash_table_data[STATS_ENTRY_SIZE * STATS_ENTRIES_SIZE];
+
+/*
+ * Keys are stored at these entries:
+ * 0: 0, 1: 1, 2: 16, 3: 17, 4: 32, 5: 46, 14: 14, 15: 30
+ * The cluster from 14 wraps around to 5.
+ */
+static const uint32_t stats_keys[] = { 0, 1, 16, 17, 32, 14, 30, 46 };
+
+static uint32_t stats_hash_function(uint8_t *key)
+{
+  stats_key_t *stats_key;
+
+  stats_key = (stats_key_t *)key;
+
+  return (stats_key->key);
+}
+
+
+void test_stats(void **state)
+{
+  (void)state;
+
+  ht_stats_t stats;
+  stats_key_t stats_key;
+
+  assert_true(ht_stats(&hash_table, &stats));
+  assert_true(stats.size == STATS_ENTRIES_SIZE);
+  assert_true(stats.count == 8);
+  assert_true(stats.tombstones == 0);
+  assert_true(stats.load_factor == 500);
+  assert_true(stats.probe_total == 16);
+  assert_true(stats.mean_probe == 2000);
+  assert_true(stats.max_probe == 7);
+  assert_true(stats.max_probe == hash_table.max_probe);
+  assert_true(stats.histogram[0] == 3);
+  assert_true(stats.histogram[1] == 1);
+  assert_true(stats.histogram[2] == 2);
+  assert_true(stats.histogram[4] == 1);
+  assert_true(stats.histogram[7] == 1);
+  assert_true(stats.largest_cluster == 8);
+  assert_true(stats.bytes_used == 8 * STATS_ENTRY_SIZE);
+  assert_true(stats.bytes_allocated == sizeof(hash_table_data));
+
+  /* A removed entry still belongs to its cluster */
+  stats_key.key = 1;
+  assert_true(ht_remove(&hash_table, (uint8_t *)&stats_key, NULL));
+  assert_true(ht_stats(&hash_table, &stats));
+  assert_true(stats.count == 7);
+  assert_true(stats.tombstones == 1);
+  assert_true(stats.histogram[0] == 2);
+  assert_true(stats.largest_cluster == 8);
+
+  /* An empty hash_table */
+  assert_true(ht_clear(&hash_table));
+  assert_true(ht_stats(&hash_table, &stats));
+  assert_true(stats.count == 0);
+  assert_true(stats.mean_probe == 0);
+  assert_true(stats.largest_cluster == 0);
+  assert_true(stats.bytes_used == 0);
+}
+
+
+void test_stats_parallel(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t threads;
+  ht_stats_t stats;
+  ht_stats_t parallel_stats;
+  stats_key_t stats_key;
+  stats_data_t stats_data;
+
+  assert_false(ht_stats_parallel(&hash_table, 0, &parallel_stats));
+  assert_false(ht_stats_parallel(&hash_table, HT_STATS_MAX_THREADS + 1,
+      &parallel_stats));
+
+  /* Ranges of every size, some of them empty, give the same statistics */
+  assert_true(ht_stats(&hash_table, &stats));
+  for (threads = 1; threads <= 20; threads++)
+  {
+    assert_true(ht_stats_parallel(&hash_table, threads, &parallel_stats));
+    assert_memory_equal(&stats, &parallel_stats, sizeof(stats));
+  }
+
+  /* Fill the hash_table, the cluster covers every entry */
+  stats_data.value = 0;
+  for (i = 0; ht_count(&hash_table) < STATS_ENTRIES_SIZE; i++)
+  {
+    stats_key.key = i;
+    ht_insert(&hash_table, (uint8_t *)&stats_key, (uint8_t *)&stats_data);
+  }
+
+  for (threads = 1; threads <= 20; threads++)
+  {
+    assert_true(ht_stats_parallel(&hash_table, threads, &parallel_stats));
+    assert_true(parallel_stats.count == STATS_ENTRIES_SIZE);
+    assert_true(parallel_stats.load_factor == 1000);
+    assert_true(parallel_stats.largest_cluster == STATS_ENTRIES_SIZE);
+  }
+}
+
+
+void test_stats_probe(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t probe;
+  uint32_t total;
+  ht_stats_t stats;
+  stats_key_t stats_key;
+  stats_data_t stats_data;
+
+  /* Distances are counted in steps of the probe sequence of the table */
+  for (probe = HT_PROBE_LINEAR; probe <= HT_PROBE_DOUBLE; probe++)
+  {
+    memset(hash_table_data, 0, sizeof(hash_table_data));
+    assert_true(ht_init_probe(&hash_table, stats_hash_function,
+        STATS_ENTRIES_SIZE, sizeof(stats_data_t), sizeof(stats_key_t),
+        hash_table_data, probe));
+
+    for (i = 0; i < sizeof(stats_keys) / sizeof(stats_keys[0]); i++)
+    {
+      stats_key.key = stats_keys[i];
+      stats_data.value = i;
+      assert_true(ht_insert(&hash_table, (uint8_t *)&stats_key,
+          (uint8_t *)&stats_data));
+    }
+
+    assert_true(ht_stats(&hash_table, &stats));
+    assert_true(stats.count == sizeof(stats_keys) / sizeof(stats_keys[0]));
+    assert_true(stats.max_probe == hash_table.max_probe);
+
+    total = 0;
+    for (i = 0; i < HT_STATS_HISTOGRAM_SIZE; i++)
+    {
+      total += stats.histogram[i];
+    }
+    assert_true(total == stats.count);
+  }
+}
+
+
+void test_stats_counters(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint64_t latency;
+  ht_counters_t counters;
+  ht_counters_t total;
+  stats_key_t stats_key;
+  stats_data_t stats_data;
+
+#ifdef HT_STATS
+  assert_true(ht_counters_reset());
+#else
+  assert_false(ht_counters_reset());
+#endif
+
+  /* One hit and one miss */
+  stats_key.key = 0;
+  ht_get(&hash_table, (uint8_t *)&stats_key, NULL);
+  stats_key.key = 2;
+  ht_get(&hash_table, (uint8_t *)&stats_key, NULL);
+
+  stats_key.key = 3;
+  stats_data.value = 3;
+  ht_insert(&hash_table, (uint8_t *)&stats_key, (uint8_t *)&stats_data);
+  ht_remove(&hash_table, (uint8_t *)&stats_key, NULL);
+
+#ifdef HT_STATS
+  assert_true(ht_counters_get(&counters));
+  assert_true(counters.calls[HT_COUNTERS_GET] == 2);
+  assert_true(counters.hits[HT_COUNTERS_GET] == 1);
+  assert_true(counters.calls[HT_COUNTERS_INSERT] == 1);
+  assert_true(counters.hits[HT_COUNTERS_INSERT] == 1);
+  assert_true(counters.calls[HT_COUNTERS_REMOVE] == 1);
+  assert_true(counters.hits[HT_COUNTERS_REMOVE] == 1);
+  assert_true(counters.finds == 4);
+  assert_true(counters.probes >= counters.compares);
+  assert_true(counters.compares >= 3);
+
+  /* Every call lands in one latency bucket */
+  for (latency = 0, i = 0; i < HT_COUNTERS_LATENCY_BUCKETS; i++)
+  {
+    latency += counters.latency[HT_COUNTERS_GET][i];
+  }
+  assert_true(latency == 2);
+#else
+  assert_false(ht_counters_get(&counters));
+  for (latency = 0, i = 0; i < HT_COUNTERS_LATENCY_BUCKETS; i++)
+  {
+    latency += counters.latency[HT_COUNTERS_GET][i];
+  }
+  assert_true(latency == 0);
+  assert_true(counters.calls[HT_COUNTERS_GET] == 0);
+#endif
+
+  /* Counters of many threads are summed */
+  memset(&total, 0, sizeof(total));
+  assert_true(ht_counters_merge(&total, &counters));
+  assert_true(ht_counters_merge(&total, &counters));
+  assert_true(total.calls[HT_COUNTERS_GET] ==
+      2 * counters.calls[HT_COUNTERS_GET]);
+  assert_true(total.probes == 2 * counters.probes);
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  stats_key_t stats_key;
+  stats_data_t stats_data;
+
+  memset(&hash_table, 0, sizeof(hash_table));
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+
+  assert_true(ht_init(&hash_table, stats_hash_function, STATS_ENTRIES_SIZE,
+      sizeof(stats_data_t), sizeof(stats_key_t), hash_table_data));
+
+  for (i = 0; i < sizeof(stats_keys) / sizeof(stats_keys[0]); i++)
+  {
+    stats_key.key = stats_keys[i];
+    stats_data.value = i;
+    assert_true(ht_insert(&hash_table, (uint8_t *)&stats_key,
+        (uint8_t *)&stats_data));
+  }
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_stats,          setup, teardown),
+    cmocka_unit_test_setup_teardown(test_stats_parallel, setup, teardown),
+    cmocka_unit_test_setup_teardown(test_stats_probe,    setup, teardown),
+    cmocka_unit_test_setup_teardown(test_stats_counters, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
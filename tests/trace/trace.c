@@ -0,0 +1,246 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Yago Fontoura do Rosário <yago.rosario@hotmail.com.br>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ht_trace.h"
+
+typedef struct {
+  uint32_t key;
+} trace_key_t;
+
+typedef struct {
+  uint32_t value;
+} trace_data_t;
+
+#define TRACE_ENTRIES_SIZE    8
+#define TRACE_BUFFER_SIZE     32
+#define TRACE_OUTPUT_SIZE     1024
+
+static ht_t hash_table;
+static uint8_t hash_table_data[(sizeof(ht_entry_t) + sizeof(trace_key_t) +
+    sizeof(trace_data_t)) * TRACE_ENTRIES_SIZE];
+
+static ht_trace_t trace;
+static uint8_t trace_buffer[TRACE_BUFFER_SIZE];
+static uint8_t trace_output[TRACE_OUTPUT_SIZE];
+static uint32_t trace_output_size;
+static uint32_t trace_writes;
+static uint8_t trace_fail;
+
+static uint32_t trace_hash_function(uint8_t *key)
+{
+  trace_key_t *trace_key;
+
+  trace_key = (trace_key_t *)key;
+
+  return (trace_key->key);
+}
+
+
+static uint8_t trace_write_function(uint8_t *data, uint32_t size,
+    void *context)
+{
+  (void)context;
+
+  if (trace_fail || trace_output_size + size > TRACE_OUTPUT_SIZE) {
+    return (0);
+  }
+
+  memcpy(trace_output + trace_output_size, data, size);
+  trace_output_size += size;
+  trace_writes++;
+
+  return (1);
+}
+
+
+void test_trace(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  trace_key_t trace_key;
+  trace_data_t trace_data;
+  ht_trace_reader_t reader;
+  ht_trace_record_t record;
+  static const uint8_t operations[] = {
+    HT_TRACE_INSERT, HT_TRACE_INSERT, HT_TRACE_INSERT, HT_TRACE_GET,
+    HT_TRACE_GET, HT_TRACE_REMOVE
+  };
+  static const uint32_t keys[] = { 1, 2, 3, 2, 9, 1 };
+
+  /* The shim runs the operation */
+  for (i = 0; i < 3; i++)
+  {
+    trace_key.key = keys[i];
+    trace_data.value = i;
+    assert_true(ht_trace_insert(&trace, &hash_table, (uint8_t *)&trace_key,
+        (uint8_t *)&trace_data));
+  }
+  trace_key.key = keys[3];
+  assert_true(ht_trace_get(&trace, &hash_table, (uint8_t *)&trace_key,
+      (uint8_t *)&trace_data));
+  assert_true(trace_data.value == 1);
+  trace_key.key = keys[4];
+  assert_false(ht_trace_get(&trace, &hash_table, (uint8_t *)&trace_key,
+      NULL));
+  trace_key.key = keys[5];
+  assert_true(ht_trace_remove(&trace, &hash_table, (uint8_t *)&trace_key,
+      NULL));
+  assert_true(ht_count(&hash_table) == 2);
+
+  /* Records are written when the buffer is full and on flush */
+  assert_true(trace_writes > 0);
+  assert_true(ht_trace_flush(&trace));
+  assert_true(trace.records == 6);
+  assert_true(trace.pending == 0);
+  assert_true(trace.dropped == 0);
+  assert_true(trace_output_size ==
+      HT_TRACE_MAGIC_SIZE + 6 * HT_TRACE_RECORD_SIZE(sizeof(trace_key_t)));
+
+  /* Read them back */
+  assert_true(ht_trace_reader_init(&reader, trace_output, trace_output_size));
+  for (i = 0; i < 6; i++)
+  {
+    assert_true(ht_trace_reader_next(&reader, &record));
+    assert_true(record.operation == operations[i]);
+    assert_true(record.key_size == sizeof(trace_key_t));
+    assert_true(record.data_size == sizeof(trace_data_t));
+    memcpy(&trace_key, record.key, sizeof(trace_key));
+    assert_true(trace_key.key == keys[i]);
+  }
+  assert_false(ht_trace_reader_next(&reader, &record));
+
+  /* A truncated record is not read */
+  assert_true(ht_trace_reader_init(&reader, trace_output,
+      trace_output_size - 1));
+  for (i = 0; i < 5; i++)
+  {
+    assert_true(ht_trace_reader_next(&reader, &record));
+  }
+  assert_false(ht_trace_reader_next(&reader, &record));
+
+  /* Anything else is not a trace */
+  assert_false(ht_trace_reader_init(&reader, trace_buffer, 2));
+  trace_output[0] = 'X';
+  assert_false(ht_trace_reader_init(&reader, trace_output,
+      trace_output_size));
+}
+
+
+void test_trace_dropped(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint8_t key[TRACE_BUFFER_SIZE];
+
+  assert_false(ht_trace_init(&trace, trace_buffer, HT_TRACE_MAGIC_SIZE - 1,
+      trace_write_function, NULL));
+
+  /* A record larger than the buffer is dropped */
+  memset(key, 0, sizeof(key));
+  assert_false(ht_trace_record(&trace, HT_TRACE_GET, key, sizeof(key), 0));
+  assert_true(trace.dropped == 1);
+
+  /* Records that cannot be written are dropped */
+  trace_fail = 1;
+  for (i = 0; i < 10; i++)
+  {
+    assert_true(ht_trace_record(&trace, HT_TRACE_GET, key, 4, 4));
+  }
+  assert_false(ht_trace_flush(&trace));
+  assert_true(trace.records == 0);
+  assert_true(trace.dropped == 11);
+
+  /* Nothing to flush */
+  assert_true(ht_trace_flush(&trace));
+}
+
+
+int setup(void **state)
+{
+  (void)state;
+
+  memset(&hash_table, 0, sizeof(hash_table));
+  memset(hash_table_data, 0, sizeof(hash_table_data));
+  trace_output_size = 0;
+  trace_writes = 0;
+  trace_fail = 0;
+
+  assert_true(ht_init(&hash_table, trace_hash_function, TRACE_ENTRIES_SIZE,
+      sizeof(trace_data_t), sizeof(trace_key_t), hash_table_data));
+  assert_true(ht_trace_init(&trace, trace_buffer, sizeof(trace_buffer),
+      trace_write_function, NULL));
+
+  return (0);
+}
+
+
+int teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_setup(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int group_teardown(void **state)
+{
+  (void)state;
+
+  return (0);
+}
+
+
+int main(void)
+{
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test_setup_teardown(test_trace,         setup, teardown),
+    cmocka_unit_test_setup_teardown(test_trace_dropped, setup, teardown),
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_XML);
+
+  int count_fail_tests = cmocka_run_group_tests(tests, group_setup,
+          group_teardown);
+
+  return (count_fail_tests);
+}
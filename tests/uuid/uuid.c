@@ -50,6 +50,8 @@ typedef struct {
 static ht_t hash_table;
 static uint8_t hash_table_data[(sizeof(ht_entry_t) + sizeof(uuid_key_t) +
     sizeof(uuid_data_t)) * UUID_HASH_ENTRIES_SIZE];
+static uint64_t hash_table_occupancy[HT_OCCUPANCY_WORDS(
+    UUID_HASH_ENTRIES_SIZE)];
 
 static uint32_t uuid_hash_function(uint8_t *key)
 {
@@ -158,6 +160,131 @@ void test_hash_iterator(void **state)
 }
 
 
+void test_hash_occupancy_iterator(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t count;
+  ht_iter_t ht_iterator;
+  uuid_key_t uuid_key;
+  uuid_data_t uuid_data;
+  uint8_t data_checker[1000];
+
+  assert_true(ht_set_occupancy(&hash_table, hash_table_occupancy));
+
+  /* Remove every other item once the bitmap is attached */
+  for (i = 1000; i > 0; i -= 2)
+  {
+    uuid_parse(uuids[i - 2], uuid_key.uuid);
+    assert_true(ht_remove(&hash_table, (uint8_t *)&uuid_key, NULL));
+  }
+
+  memset(data_checker, 0, sizeof(data_checker));
+  ht_iter_init(&ht_iterator, &hash_table);
+
+  count = 0;
+  while (ht_iter_get_next(&ht_iterator,
+      &hash_table, (uint8_t *)&uuid_key,
+      (uint8_t *)&uuid_data))
+  {
+    assert_true(uuid_data.x % 2 == 1);
+    assert_true(data_checker[uuid_data.x] == 0);
+    data_checker[uuid_data.x] = 1;
+    count++;
+  }
+
+  assert_true(count == 500);
+  assert_true(ht_count(&hash_table) == 500);
+
+  /* Cleared items are skipped until their slice of the bitmap is reset */
+  assert_true(ht_clear(&hash_table));
+  uuid_parse(uuids[1], uuid_key.uuid);
+  uuid_data.x = 1;
+  assert_true(ht_insert(&hash_table, (uint8_t *)&uuid_key,
+      (uint8_t *)&uuid_data));
+
+  ht_iter_init(&ht_iterator, &hash_table);
+  assert_true(ht_iter_get_next(&ht_iterator, &hash_table,
+      (uint8_t *)&uuid_key, (uint8_t *)&uuid_data));
+  assert_true(uuid_data.x == 1);
+  assert_false(ht_iter_get_next(&ht_iterator, &hash_table,
+      (uint8_t *)&uuid_key, (uint8_t *)&uuid_data));
+
+  /* A whole wrap of the generation resets every bit */
+  for (i = 0; i < (1 << HT_GENERATION_BITS); i++)
+  {
+    assert_true(ht_clear(&hash_table));
+  }
+
+  for (i = 0; i < HT_OCCUPANCY_WORDS(UUID_HASH_ENTRIES_SIZE); i++)
+  {
+    assert_true(hash_table_occupancy[i] == 0);
+  }
+}
+
+
+static void parallel_callback(uint8_t *key, uint8_t *data, uint32_t part,
+    void *context)
+{
+  uuid_t uuid;
+  uuid_key_t *uuid_key;
+  uuid_data_t *uuid_data;
+  uint8_t *data_checker;
+
+  (void)part;
+
+  uuid_key = (uuid_key_t *)key;
+  uuid_data = (uuid_data_t *)data;
+  data_checker = (uint8_t *)context;
+
+  /* Each item is visited by exactly one range */
+  data_checker[uuid_data->x]++;
+
+  uuid_parse(uuids[uuid_data->x], uuid);
+  if (uuid_compare(uuid, uuid_key->uuid)) {
+    data_checker[uuid_data->x]++;
+  }
+}
+
+
+void test_hash_parallel_iterator(void **state)
+{
+  (void)state;
+
+  uint32_t i;
+  uint32_t count;
+  ht_iter_t ht_iterator;
+  uuid_key_t uuid_key;
+  uuid_data_t uuid_data;
+  uint8_t data_checker[1000];
+
+  memset(data_checker, 0, sizeof(data_checker));
+  assert_true(ht_parallel_foreach(&hash_table, 4, parallel_callback,
+      data_checker));
+
+  /* Verify data checker */
+  for (i = 0; i < 1000; i++)
+  {
+    assert_true(data_checker[i] == 1);
+  }
+
+  /* The ranges cover all the entries without overlapping */
+  count = 0;
+  for (i = 0; i < 7; i++)
+  {
+    assert_true(ht_iter_init_range(&ht_iterator, &hash_table, i, 7));
+    while (ht_iter_get_next(&ht_iterator, &hash_table,
+        (uint8_t *)&uuid_key, (uint8_t *)&uuid_data))
+    {
+      count++;
+    }
+  }
+  assert_true(count == 1000);
+  assert_false(ht_iter_init_range(&ht_iterator, &hash_table, 7, 7));
+}
+
+
 int setup(void **state)
 {
   (void)state;
@@ -226,10 +353,14 @@ int main(void)
 {
   const struct CMUnitTest tests[] =
   {
-    cmocka_unit_test_setup_teardown(test_hash,          setup,
+    cmocka_unit_test_setup_teardown(test_hash,                   setup,
+        teardown),
+    cmocka_unit_test_setup_teardown(test_hash_iterator,          setup,
         teardown),
-    cmocka_unit_test_setup_teardown(test_hash_iterator, setup,
+    cmocka_unit_test_setup_teardown(test_hash_parallel_iterator, setup,
         teardown),
+    cmocka_unit_test_setup_teardown(test_hash_occupancy_iterator,
+        setup, teardown),
   };
 
   cmocka_set_message_output(CM_OUTPUT_XML);